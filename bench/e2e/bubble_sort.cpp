@@ -0,0 +1,24 @@
+// End-to-end corpus: bubble sort.
+// Reads, compares and swaps on a single vector, about n^2 / 2 frames.
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &v)
+{
+    auto arr = v.get_vector<int>("arr");
+    int n = static_cast<int>(arr.size());
+
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j + 1 < n - i; ++j)
+        {
+            int left = arr[j], right = arr[j + 1];
+            if (left > right)
+            {
+                arr[j] = right;
+                arr[j + 1] = left;
+            }
+        }
+    }
+    viz.log_frame("Sorted {} elements.", n);
+}
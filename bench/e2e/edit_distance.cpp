@@ -0,0 +1,30 @@
+// End-to-end corpus: edit distance.
+// Fills a (|a| + 1) x (|b| + 1) DP table cell by cell, three reads and one write per cell.
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &v)
+{
+    auto a = v.get_vector<int>("a");
+    auto b = v.get_vector<int>("b");
+    int n = static_cast<int>(a.size()), m = static_cast<int>(b.size());
+    auto dp = v.new_matrix<int>("dp", n + 1, m + 1);
+
+    for (int i = 0; i <= n; ++i)
+        dp[i][0] = i;
+    for (int j = 0; j <= m; ++j)
+        dp[0][j] = j;
+
+    for (int i = 1; i <= n; ++i)
+    {
+        int ai = a[i - 1];
+        for (int j = 1; j <= m; ++j)
+        {
+            int bj = b[j - 1];
+            int replace = dp[i - 1][j - 1], erase = dp[i - 1][j], insert = dp[i][j - 1];
+            dp[i][j] = min({replace + (ai != bj), erase + 1, insert + 1});
+        }
+    }
+    int distance = dp[n][m];
+    viz.log_frame("Edit distance is {}.", distance);
+}
@@ -0,0 +1,35 @@
+// End-to-end corpus: breadth-first search on a grid.
+// A queue of cells, a distance table and reads of the input grid (1 = wall).
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &v)
+{
+    auto grid = v.get_matrix<int>("grid");
+    int rows = static_cast<int>(grid.rows()), cols = static_cast<int>(grid.cols());
+    auto dist = v.new_matrix<int>("dist", rows, cols, -1);
+    auto frontier = v.new_queue<int>("frontier");
+
+    dist[0][0] = 0;
+    frontier.push(0);
+    const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    while (!frontier.empty())
+    {
+        int cell = frontier.front();
+        frontier.pop();
+        int r = cell / cols, c = cell % cols;
+        int d = dist[r][c];
+        for (auto [dr, dc] : steps)
+        {
+            int nr = r + dr, nc = c + dc;
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+                continue;
+            int wall = grid[nr][nc], seen = dist[nr][nc];
+            if (wall == 1 || seen != -1)
+                continue;
+            dist[nr][nc] = d + 1;
+            frontier.push(nr * cols + nc);
+        }
+    }
+    viz.log_frame("Visited every reachable cell.");
+}
@@ -0,0 +1,31 @@
+// End-to-end corpus: the primes up to n, with the sieve of Eratosthenes.
+// Crosses out multiples by writing to a v_vector<bool>, whose elements are proxy references.
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &v)
+{
+    auto n = v.get_scalar<int>("n");
+    int limit = n;
+    auto is_prime = v.new_vector<bool>("is_prime", vector<bool>(max(limit + 1, 2), true));
+    is_prime[0] = false;
+    is_prime[1] = false;
+
+    for (int i = 2; i * i <= limit; ++i)
+    {
+        bool prime = is_prime[i];
+        if (!prime)
+            continue;
+        for (int j = i * i; j <= limit; j += i)
+            is_prime[j] = false;
+    }
+
+    auto primes = v.new_vector<int>("primes");
+    for (int i = 2; i <= limit; ++i)
+    {
+        bool prime = is_prime[i];
+        if (prime)
+            primes.push_back(i);
+    }
+    viz.log_frame("Found {} primes up to {}.", primes.size(), limit);
+}
@@ -0,0 +1,33 @@
+// End-to-end corpus: the k most frequent values.
+// Counts with map reads and writes, then ranks (count, value) keys in a priority queue.
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &v)
+{
+    auto arr = v.get_vector<int>("arr");
+    auto k = v.get_scalar<int>("k");
+    auto counts = v.new_map<int, int>("counts");
+
+    int n = static_cast<int>(arr.size());
+    for (int i = 0; i < n; ++i)
+    {
+        int value = arr[i];
+        int seen = counts[value];
+        counts[value] = seen + 1;
+    }
+
+    // Values stay below 100000, so count * 100000 + value orders by count, then value
+    auto ranked = v.new_priority_queue<long long>("ranked");
+    for (const auto &[value, count] : counts.data)
+        ranked.push(static_cast<long long>(count) * 100000 + value);
+
+    auto top = v.new_vector<int>("top");
+    for (int i = 0; i < (int)k && !ranked.empty(); ++i)
+    {
+        long long best = ranked.top();
+        ranked.pop();
+        top.push_back(static_cast<int>(best % 100000));
+    }
+    viz.log_frame("Found the {} most frequent values.", top.size());
+}
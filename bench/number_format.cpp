@@ -0,0 +1,64 @@
+// ########## Benchmark: exporting large numeric containers ##########
+// Compares the JSON text export of 1M-element vector<int> / vector<double> through
+//   1. nlohmann:  the old per-element path, json(vec).dump()
+//   2. bulk:      VizValueWriter + VizValueReader::to_json, the engine's export path
+// and checks that both give the same numbers.
+//
+// Build and run (from the repository root):
+//   emcc -std=c++20 -O3 --bind -I src/cpp bench/number_format.cpp -o number_format.js && node number_format.js
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &) {} // Not used, the bindings in v-cpp.hpp just need it
+
+template <typename Func>
+double best_ms(Func &&func, int runs = 5)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = chrono::steady_clock::now();
+        func();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+template <typename T>
+void compare_paths(const string &label, const vector<T> &values)
+{
+    string reference, bulk, encoded;
+    double nlohmann_ms = best_ms([&] { reference = json(values).dump(); });
+    double encode_ms = best_ms([&] { encoded.clear(); VizValueWriter{{encoded}}.write(values); });
+    double format_ms = best_ms([&] { bulk.clear(); VizValueReader::to_json(encoded, bulk); });
+
+    // Doubles may come out shorter than json::dump() writes them, but must read back the same
+    bool same = json::parse(bulk) == json::parse(reference);
+
+    double per = 1e6 / values.size();
+    printf("%-14s nlohmann %8.2f ms (%6.1f ns/elem)   bulk %8.2f ms (%6.1f ns/elem) = encode %.2f + format %.2f   %s\n",
+           label.c_str(), nlohmann_ms, nlohmann_ms * per, encode_ms + format_ms, (encode_ms + format_ms) * per,
+           encode_ms, format_ms, same ? "same values" : "MISMATCH");
+}
+
+int main()
+{
+    constexpr size_t count = 1'000'000;
+    mt19937_64 rng(12345);
+
+    vector<int> small_ints(count), ints(count);
+    vector<double> doubles(count), decimals(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        small_ints[i] = static_cast<int>(rng() % 1000);
+        ints[i] = static_cast<int>(rng());
+        doubles[i] = uniform_real_distribution<double>(-1e6, 1e6)(rng);
+        decimals[i] = static_cast<double>(static_cast<int64_t>(rng() % 2000001) - 1000000) / 100.0;
+    }
+
+    compare_paths("int [0,1000)", small_ints);
+    compare_paths("int (full)", ints);
+    compare_paths("double", doubles);
+    compare_paths("double (x.yy)", decimals);
+    return 0;
+}
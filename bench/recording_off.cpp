@@ -0,0 +1,151 @@
+// ########## Benchmark: wrappers with recording compiled out ##########
+// Runs the same two algorithms
+//   1. wrapped:  written against VCtx and the v_ wrappers, the way run_my_algorithm is written
+//   2. plain:    the same code on std containers
+// and checks that both give the same result. Built with V_CPP_NO_RECORDING the wrapped
+// version should run as fast as the plain one; built without it, the difference is what
+// recording costs.
+//
+// Build and run (from the repository root):
+//   emcc -std=c++20 -O3 --bind -DV_CPP_NO_RECORDING -I src/cpp bench/recording_off.cpp -o recording_off.js && node recording_off.js
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &) {} // Not used, the bindings in v-cpp.hpp just need it
+
+template <typename Func>
+double best_ms(Func &&func, int runs = 5)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = chrono::steady_clock::now();
+        func();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// --- Edit distance on a (n + 1) x (m + 1) DP table ---
+int edit_distance_wrapped(VCtx &v, const vector<int> &a, const vector<int> &b)
+{
+    int n = static_cast<int>(a.size()), m = static_cast<int>(b.size());
+    auto dp = v.new_matrix<int>("dp", n + 1, m + 1);
+    for (int i = 0; i <= n; ++i)
+        dp[i][0] = i;
+    for (int j = 0; j <= m; ++j)
+        dp[0][j] = j;
+    for (int i = 1; i <= n; ++i)
+        for (int j = 1; j <= m; ++j)
+        {
+            int replace = dp[i - 1][j - 1], erase = dp[i - 1][j], insert = dp[i][j - 1];
+            dp[i][j] = min({replace + (a[i - 1] != b[j - 1]), erase + 1, insert + 1});
+        }
+    return dp[n][m];
+}
+
+int edit_distance_plain(const vector<int> &a, const vector<int> &b)
+{
+    int n = static_cast<int>(a.size()), m = static_cast<int>(b.size());
+    vector<vector<int>> dp(n + 1, vector<int>(m + 1));
+    for (int i = 0; i <= n; ++i)
+        dp[i][0] = i;
+    for (int j = 0; j <= m; ++j)
+        dp[0][j] = j;
+    for (int i = 1; i <= n; ++i)
+        for (int j = 1; j <= m; ++j)
+            dp[i][j] = min({dp[i - 1][j - 1] + (a[i - 1] != b[j - 1]), dp[i - 1][j] + 1, dp[i][j - 1] + 1});
+    return dp[n][m];
+}
+
+// --- BFS over a side x side grid with walls, returns the sum of all distances ---
+long long grid_bfs_wrapped(VCtx &v, const vector<char> &wall, int side)
+{
+    auto dist = v.new_vector<int>("dist", vector<int>(wall.size(), -1));
+    auto frontier = v.new_queue<int>("frontier");
+    dist[0] = 0;
+    frontier.push(0);
+    long long total = 0;
+    const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    while (!frontier.empty())
+    {
+        int cell = frontier.front();
+        frontier.pop();
+        int d = dist[cell];
+        total += d;
+        for (auto [dr, dc] : steps)
+        {
+            int r = cell / side + dr, c = cell % side + dc;
+            if (r < 0 || r >= side || c < 0 || c >= side || wall[r * side + c])
+                continue;
+            int next = r * side + c, seen = dist[next];
+            if (seen != -1)
+                continue;
+            dist[next] = d + 1;
+            frontier.push(next);
+        }
+    }
+    return total;
+}
+
+long long grid_bfs_plain(const vector<char> &wall, int side)
+{
+    vector<int> dist(wall.size(), -1);
+    queue<int> frontier;
+    dist[0] = 0;
+    frontier.push(0);
+    long long total = 0;
+    const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    while (!frontier.empty())
+    {
+        int cell = frontier.front();
+        frontier.pop();
+        total += dist[cell];
+        for (auto [dr, dc] : steps)
+        {
+            int r = cell / side + dr, c = cell % side + dc;
+            if (r < 0 || r >= side || c < 0 || c >= side || wall[r * side + c] || dist[r * side + c] != -1)
+                continue;
+            dist[r * side + c] = dist[cell] + 1;
+            frontier.push(r * side + c);
+        }
+    }
+    return total;
+}
+
+template <typename Wrapped, typename Plain>
+void compare_paths(const string &label, Wrapped &&wrapped, Plain &&plain)
+{
+    long long wrapped_result = 0, plain_result = 0;
+    double wrapped_ms = best_ms([&] {
+        viz.reset();
+        VCtx v({});
+        wrapped_result = wrapped(v);
+    });
+    double plain_ms = best_ms([&] { plain_result = plain(); });
+
+    printf("%-26s wrapped %8.2f ms   plain %8.2f ms   ratio %5.2fx   %s\n", label.c_str(), wrapped_ms, plain_ms,
+           wrapped_ms / plain_ms, wrapped_result == plain_result ? "same result" : "MISMATCH");
+}
+
+int main()
+{
+    printf("recording %s\n", viz_recording ? "ON (build with -DV_CPP_NO_RECORDING to compile it out)" : "compiled out");
+    mt19937 rng(12345);
+
+    vector<int> a(2000), b(2000);
+    for (auto &x : a)
+        x = static_cast<int>(rng() % 4);
+    for (auto &x : b)
+        x = static_cast<int>(rng() % 4);
+    compare_paths("edit distance 2000x2000", [&](VCtx &v) { return edit_distance_wrapped(v, a, b); },
+                  [&] { return edit_distance_plain(a, b); });
+
+    constexpr int side = 1000;
+    vector<char> wall(side * side);
+    for (size_t i = 1; i < wall.size(); ++i)
+        wall[i] = rng() % 4 == 0;
+    compare_paths("grid BFS 1000x1000", [&](VCtx &v) { return grid_bfs_wrapped(v, wall, side); },
+                  [&] { return grid_bfs_plain(wall, side); });
+    return 0;
+}
@@ -0,0 +1,250 @@
+// ########## Benchmark: the cost of every wrapper operation ##########
+// Measures single operations on containers of 10 to 1M elements:
+//   ns/op       time per operation, with the frame it logs
+//   hist B/op   bytes the operation adds to the exported (VCPB) history
+//   live B/op   bytes the operation adds to the history the engine holds (VizEngine::stats)
+//   allocs/op   heap allocations per operation, and the bytes they ask for
+// Every container is created first; only the operations on it are measured. The frame budget is
+// unlimited by default so every operation pays for its frame (pass a budget to see the sampled path).
+//
+// Build and run (from the repository root):
+//   emcc -std=c++20 -O3 --bind -I src/cpp bench/wrapper_ops.cpp -o wrapper_ops.js && node wrapper_ops.js [filter] [budget]
+// or natively: cmake --build build --target bench_wrapper_ops && build/bench_wrapper_ops [filter] [budget]
+// `filter` keeps the operations whose name contains it.
+
+#include "v-cpp.hpp"
+
+void run_my_algorithm(VCtx &) {} // Not used, the bindings in v-cpp.hpp just need it
+
+// --- Allocation counting: every heap allocation of the program goes through these ---
+static size_t alloc_count = 0, alloc_bytes = 0;
+
+void *operator new(size_t bytes)
+{
+    alloc_count++;
+    alloc_bytes += bytes;
+    if (void *p = malloc(bytes ? bytes : 1))
+        return p;
+    throw bad_alloc();
+}
+void *operator new(size_t bytes, align_val_t alignment)
+{
+    alloc_count++;
+    alloc_bytes += bytes;
+    size_t align = static_cast<size_t>(alignment);
+    if (void *p = aligned_alloc(align, (bytes + align - 1) / align * align))
+        return p;
+    throw bad_alloc();
+}
+// Not inlined: the compiler would otherwise see free() on what operator new returned and warn
+// (-Wmismatched-new-delete), not knowing that this operator new is malloc
+[[gnu::noinline]] void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete(void *p, align_val_t) noexcept { operator delete(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { operator delete(p); }
+
+// --- Measures the `ops` operations between start() and stop() ---
+class Meter
+{
+public:
+    explicit Meter(size_t ops) : ops(ops) {}
+
+    void start()
+    {
+        history_before = viz.dump_history_binary().size();
+        live_before = viz.stats().live();
+        allocs_before = alloc_count, bytes_before = alloc_bytes;
+        started = chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        auto stopped = chrono::steady_clock::now();
+        allocs = alloc_count - allocs_before, bytes = alloc_bytes - bytes_before;
+        ns = chrono::duration<double, nano>(stopped - started).count();
+        live = static_cast<ptrdiff_t>(viz.stats().live()) - static_cast<ptrdiff_t>(live_before);
+        history = viz.dump_history_binary().size() - history_before;
+    }
+
+    void print(const char *name, size_t size) const
+    {
+        printf("%-22s %8zu %8zu %10.1f %10.1f %10.1f %10.2f %12.1f\n", name, size, ops, ns / ops, double(history) / ops,
+               double(live) / ops, double(allocs) / ops, double(bytes) / ops);
+    }
+
+    const size_t ops;
+
+private:
+    chrono::steady_clock::time_point started;
+    size_t history_before = 0, live_before = 0, allocs_before = 0, bytes_before = 0;
+    ptrdiff_t live = 0;
+    size_t allocs = 0, bytes = 0, history = 0;
+    double ns = 0;
+};
+
+static vector<int> iota_vector(size_t n)
+{
+    vector<int> values(n);
+    iota(values.begin(), values.end(), 0);
+    return values;
+}
+
+// Every benchmark builds its container of `n` elements, then runs meter.ops operations on it
+struct Benchmark
+{
+    const char *name;
+    void (*run)(VCtx &v, size_t n, Meter &meter);
+    bool linear_export = false; // Exporting one of its ops scans the whole container
+};
+
+static const Benchmark benchmarks[] = {
+    {"vector.push_back", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto vec = v.new_vector<int>("vec", iota_vector(n));
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             vec.push_back(static_cast<int>(i));
+         meter.stop();
+     }},
+    {"vector[i] read", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto vec = v.new_vector<int>("vec", iota_vector(n));
+         long long sum = 0;
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+         {
+             int x = vec[static_cast<int>(i % n)];
+             sum += x;
+         }
+         meter.stop();
+         if (sum < 0)
+             puts(""); // Keeps the reads
+     }},
+    {"vector[i] write", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto vec = v.new_vector<int>("vec", iota_vector(n));
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             vec[static_cast<int>(i % n)] = static_cast<int>(i);
+         meter.stop();
+     }},
+    {"matrix[r][c] read", [](VCtx &v, size_t n, Meter &meter)
+     {
+         size_t side = max<size_t>(1, static_cast<size_t>(sqrt(double(n))));
+         auto dp = v.new_matrix<int>("dp", side, side, 1);
+         long long sum = 0;
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+         {
+             int x = dp[static_cast<int>(i / side % side)][static_cast<int>(i % side)];
+             sum += x;
+         }
+         meter.stop();
+         if (sum < 0)
+             puts("");
+     }},
+    {"matrix[r][c] write", [](VCtx &v, size_t n, Meter &meter)
+     {
+         size_t side = max<size_t>(1, static_cast<size_t>(sqrt(double(n))));
+         auto dp = v.new_matrix<int>("dp", side, side, 1);
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             dp[static_cast<int>(i / side % side)][static_cast<int>(i % side)] = static_cast<int>(i);
+         meter.stop();
+     }},
+    {"stack.push/pop", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto st = v.new_stack<int>("st", deque<int>(n, 1));
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             i % 2 == 0 ? st.push(static_cast<int>(i)) : st.pop();
+         meter.stop();
+     }},
+    {"priority_queue.push/pop", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto pq = v.new_priority_queue<int>("pq", iota_vector(n));
+         mt19937 rng(1);
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             i % 2 == 0 ? pq.push(static_cast<int>(rng() % (2 * n))) : pq.pop();
+         meter.stop();
+     }},
+    {"set.insert", [](VCtx &v, size_t n, Meter &meter)
+     {
+         vector<int> evens(n);
+         for (size_t i = 0; i < n; ++i)
+             evens[i] = static_cast<int>(2 * i);
+         auto s = v.new_set<int>("s", set<int>(evens.begin(), evens.end()));
+         mt19937 rng(1);
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             s.insert(static_cast<int>(rng() % (2 * n))); // About half of them are new
+         meter.stop();
+     }},
+    {"map[k] read", [](VCtx &v, size_t n, Meter &meter)
+     {
+         map<int, int> initial;
+         for (size_t i = 0; i < n; ++i)
+             initial.emplace(static_cast<int>(i), static_cast<int>(i));
+         auto m = v.new_map<int, int>("m", initial);
+         mt19937 rng(1);
+         long long sum = 0;
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+         {
+             int x = m[static_cast<int>(rng() % n)];
+             sum += x;
+         }
+         meter.stop();
+         if (sum < 0)
+             puts("");
+     }},
+    {"map[k] write", [](VCtx &v, size_t n, Meter &meter)
+     {
+         map<int, int> initial;
+         for (size_t i = 0; i < n; ++i)
+             initial.emplace(static_cast<int>(i), static_cast<int>(i));
+         auto m = v.new_map<int, int>("m", initial);
+         mt19937 rng(1);
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             m[static_cast<int>(rng() % n)] = static_cast<int>(i);
+         meter.stop();
+     },
+     true},
+    {"log_frame", [](VCtx &v, size_t n, Meter &meter)
+     {
+         auto vec = v.new_vector<int>("vec", iota_vector(n)); // Frames show it, unchanged
+         meter.start();
+         for (size_t i = 0; i < meter.ops; ++i)
+             viz.log_frame("Step {} of {}", i, meter.ops);
+         meter.stop();
+     }},
+};
+
+int main(int argc, char **argv)
+{
+    string filter = argc > 1 ? argv[1] : "";
+    size_t budget = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+
+    printf("%-22s %8s %8s %10s %10s %10s %10s %12s\n", "operation", "size", "ops", "ns/op", "hist B/op", "live B/op", "allocs/op", "alloc B/op");
+    for (const auto &[name, run, linear_export] : benchmarks)
+    {
+        if (string(name).find(filter) == string::npos)
+            continue;
+        for (size_t n = 10; n <= 1'000'000; n *= 10)
+        {
+            // 100k operations, enough to include the full copies made every so many ops, but
+            // fewer on the large containers whose export would take minutes
+            Meter meter(linear_export ? clamp<size_t>(1'000'000'000 / n, 1000, 100'000) : 100'000);
+            viz.reset();
+            viz.frame_budget = budget;
+            {
+                VCtx v({});
+                run(v, n, meter);
+            }
+            meter.print(name, n);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Build-time benchmark: how long the edit-compile loop takes after changing an algorithm.
+// Times the same algorithm built header-only (the engine is compiled along with it) and against
+// the prebuilt engine (v-cpp.o, compiled once from src/cpp/v-cpp.cpp; see "Faster Rebuilds" in
+// the README). Uses emcc with the README's flags, or the native compiler when emcc is not found.
+//
+// Usage: node scripts/bench-compile.js [options]
+//   --algorithm FILE  The file defining run_my_algorithm (default src/cpp/algorithms.cpp)
+//   --runs N          Builds per step; the median is reported (default 3)
+//   --cxx CMD         Compiler to use instead of emcc (e.g. g++, clang++)
+//   --json FILE       Also write every measurement to FILE
+//
+// It reports
+//   engine     compiling v-cpp.o, once per compiler version and flags (prebuilt only)
+//   compile    compiling the algorithm
+//   link       linking it into the module (or, natively, with the runner)
+//   rebuild    compile + link: what every change to the algorithm costs
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { execFileSync } = require('child_process');
+
+const root = path.resolve(__dirname, '..');
+const include = path.join(root, 'src/cpp');
+
+function parseArgs(argv) {
+  const options = { algorithm: path.join(include, 'algorithms.cpp'), runs: 3, cxx: null, json: null };
+  for (let i = 0; i < argv.length; i += 1) {
+    const arg = argv[i];
+    const value = argv[i + 1];
+    if (arg === '--algorithm') options.algorithm = path.resolve(value), i += 1;
+    else if (arg === '--runs') options.runs = Math.max(1, Number(value) || 1), i += 1;
+    else if (arg === '--cxx') options.cxx = value, i += 1;
+    else if (arg === '--json') options.json = value, i += 1;
+    else throw new Error(`Unknown option ${arg}`);
+  }
+  return options;
+}
+
+function hasCommand(command) {
+  try {
+    execFileSync(command, ['--version'], { stdio: 'ignore' });
+    return true;
+  } catch (e) {
+    return false;
+  }
+}
+
+// --- The toolchain: emcc builds the module the app loads, a native compiler the v-cpp-run runner ---
+function toolchain(options, dir) {
+  const compile = ['-std=c++20', '-O3', '-I', include];
+  if (!options.cxx && hasCommand('emcc')) {
+    return {
+      cxx: 'emcc',
+      compile,
+      output: path.join(dir, 'algorithms.js'),
+      link: ['-O3', '-s', 'WASM=1', '-s', 'MODULARIZE=1', '-s', 'EXPORT_NAME=createAlgoModule',
+        '-s', 'EXPORTED_RUNTIME_METHODS=["cwrap"]', '--bind'],
+      extraObjects: () => [],
+    };
+  }
+  const cxx = options.cxx || process.env.CXX || 'g++';
+  if (!hasCommand(cxx)) throw new Error(`Neither emcc nor ${cxx} was found`);
+  // Natively the algorithm needs a main(): the runner, compiled once per mode and not timed
+  return {
+    cxx,
+    compile,
+    output: path.join(dir, 'v-cpp-run'),
+    link: [],
+    extraObjects: (defines) => {
+      const object = path.join(dir, `runner${defines.length ? '-prebuilt' : ''}.o`);
+      if (!fs.existsSync(object)) execFileSync(cxx, [...compile, ...defines, '-c', path.join(include, 'runner.cpp'), '-o', object]);
+      return [object];
+    },
+  };
+}
+
+const msSince = (started) => Number(process.hrtime.bigint() - started) / 1e6;
+
+function timed(command, args) {
+  const started = process.hrtime.bigint();
+  execFileSync(command, args, { stdio: ['ignore', 'ignore', 'inherit'] });
+  return msSince(started);
+}
+
+function median(values) {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.floor((sorted.length - 1) / 2)];
+}
+
+// --- One mode: the engine (prebuilt only), then `runs` rebuilds of the algorithm ---
+function measure(tools, options, dir, prebuilt) {
+  const defines = prebuilt ? ['-DV_CPP_PREBUILT'] : [];
+  const engineObject = path.join(dir, 'v-cpp.o');
+  const algorithmObject = path.join(dir, 'algorithm.o');
+  const extra = tools.extraObjects(defines);
+  const times = { engine: [], compile: [], link: [] };
+  for (let i = 0; i < options.runs; i += 1) {
+    if (prebuilt) times.engine.push(timed(tools.cxx, [...tools.compile, '-c', path.join(include, 'v-cpp.cpp'), '-o', engineObject]));
+    times.compile.push(timed(tools.cxx, [...tools.compile, ...defines, '-c', options.algorithm, '-o', algorithmObject]));
+    const objects = [algorithmObject, ...(prebuilt ? [engineObject] : []), ...extra];
+    times.link.push(timed(tools.cxx, [...objects, ...tools.link, '-o', tools.output]));
+  }
+  const engine = prebuilt ? median(times.engine) : NaN;
+  const compile = median(times.compile);
+  const link = median(times.link);
+  return { mode: prebuilt ? 'prebuilt' : 'header-only', engine, compile, link, rebuild: compile + link, times };
+}
+
+const seconds = (ms) => (Number.isNaN(ms) ? '-' : (ms / 1000).toFixed(2));
+
+function printRow(columns) {
+  const widths = [12, 10, 10, 10, 10];
+  console.log(columns.map((column, i) => String(column)[i < 1 ? 'padEnd' : 'padStart'](widths[i])).join(' '));
+}
+
+function main() {
+  const options = parseArgs(process.argv.slice(2));
+  if (!fs.existsSync(options.algorithm)) throw new Error(`No such file ${options.algorithm}`);
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'v-cpp-bench-compile-'));
+  try {
+    const tools = toolchain(options, dir);
+    console.log(`${tools.cxx}, ${path.relative(root, options.algorithm)}, median of ${options.runs} builds`);
+    printRow(['mode', 'engine', 'compile', 'link', 'rebuild']);
+    printRow(['', 's', 's', 's', 's']);
+    const results = [false, true].map((prebuilt) => {
+      const result = measure(tools, options, dir, prebuilt);
+      printRow([result.mode, seconds(result.engine), seconds(result.compile), seconds(result.link), seconds(result.rebuild)]);
+      return result;
+    });
+    const [headerOnly, prebuilt] = results;
+    console.log(`Rebuilding after an edit: ${(headerOnly.rebuild / prebuilt.rebuild).toFixed(1)}x faster with the prebuilt engine`);
+    if (options.json) fs.writeFileSync(options.json, JSON.stringify({ compiler: tools.cxx, results }, null, 2) + '\n');
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}
+
+try {
+  main();
+} catch (e) {
+  console.error(`bench-compile: ${e.message}`);
+  process.exit(1);
+}
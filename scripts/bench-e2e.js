@@ -0,0 +1,217 @@
+// End-to-end benchmark of the compiled engine: what a user waits for after pressing "Visualize!".
+// Builds every algorithm in bench/e2e/ with emcc, then runs it in Node on generated inputs of a few
+// sizes through Module.visualizeMyLogic, the same call the app makes. No browser is needed.
+//
+// Usage: node scripts/bench-e2e.js [options]
+//   --only NAME      Run only the algorithms whose name contains NAME
+//   --runs N         Fresh module instances per case; the median is reported (default 3)
+//   --json FILE      Also write every measurement to FILE
+//   --out DIR        Where the compiled modules go (default bench/e2e/build)
+//   --no-build       Use the modules already in DIR instead of (re)building stale ones
+//
+// For every algorithm and input size it reports
+//   instantiate  createAlgoModule(): fetching, compiling and instantiating the wasm
+//   run          Module.visualizeMyLogic(input), which returns the JSON history
+//   payload      size of the returned string
+//   parse        JSON.parse of that string
+//   peak mem     size of the wasm memory after the run (it only grows, so this is its peak)
+// The exit code is non-zero if a run fails or does not return an array of frames.
+const fs = require('fs');
+const path = require('path');
+const { execFileSync } = require('child_process');
+
+const root = path.resolve(__dirname, '..');
+
+function parseArgs(argv) {
+  const options = { only: '', runs: 3, json: null, out: path.join(root, 'bench/e2e/build'), build: true };
+  for (let i = 0; i < argv.length; i += 1) {
+    const arg = argv[i];
+    const value = argv[i + 1];
+    if (arg === '--only') options.only = value, i += 1;
+    else if (arg === '--runs') options.runs = Math.max(1, Number(value) || 1), i += 1;
+    else if (arg === '--json') options.json = value, i += 1;
+    else if (arg === '--out') options.out = path.resolve(value), i += 1;
+    else if (arg === '--no-build') options.build = false;
+    else throw new Error(`Unknown option ${arg}`);
+  }
+  return options;
+}
+
+// --- Seeded inputs: every run of the benchmark sees the same data ---
+function mulberry32(seed) {
+  return () => {
+    seed = (seed + 0x6d2b79f5) | 0;
+    let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+const randomInts = (random, n, limit) => Array.from({ length: n }, () => Math.floor(random() * limit));
+const vector = (values) => `{${values.join(',')}}`;
+
+// Sizes go from a few hundred frames to payloads of about 100 MB, where the JSON history is what hurts
+const corpus = [
+  {
+    name: 'bubble_sort',
+    sizes: [30, 100, 300],
+    input: (n, random) => `arr=${vector(randomInts(random, n, 1000))}`,
+  },
+  {
+    name: 'sliding_window',
+    sizes: [100, 300, 1000],
+    input: (n, random) => `arr=${vector(randomInts(random, n, 1000000))}, k=${Math.max(1, Math.floor(n / 100))}`,
+  },
+  {
+    name: 'edit_distance',
+    sizes: [10, 30, 60],
+    input: (n, random) => `a=${vector(randomInts(random, n, 4))}, b=${vector(randomInts(random, n, 4))}`,
+  },
+  {
+    name: 'grid_bfs',
+    sizes: [10, 20, 40],
+    input: (n, random) => {
+      const rows = Array.from({ length: n }, (_, r) =>
+        vector(Array.from({ length: n }, (_, c) => (r + c > 0 && random() < 0.25 ? 1 : 0))));
+      return `grid={${rows.join(',')}}`;
+    },
+  },
+  {
+    name: 'sieve',
+    sizes: [100, 300, 1000],
+    input: (n) => `n=${n}`,
+  },
+  {
+    name: 'top_k',
+    sizes: [100, 1000, 3000],
+    input: (n, random) => `arr=${vector(randomInts(random, n, Math.max(10, Math.floor(n / 10))))}, k=10`,
+  },
+];
+
+// --- Building the modules with the flags from the README, plus memory growth for the large cases ---
+function isStale(output, sources) {
+  if (!fs.existsSync(output)) return true;
+  const built = fs.statSync(output).mtimeMs;
+  return sources.some((source) => fs.statSync(source).mtimeMs > built);
+}
+
+function buildModule(name, outDir) {
+  const source = path.join(root, 'bench/e2e', `${name}.cpp`);
+  const output = path.join(outDir, `${name}.js`);
+  const engine = ['v-cpp.hpp', 'libraries.hpp', 'json.hpp', 'v-cpp/engine.hpp', 'v-cpp/serializer.hpp', 'v-cpp/parser.hpp',
+    'v-cpp/bindings.hpp'].map((file) => path.join(root, 'src/cpp', file));
+  if (!isStale(output, [source, ...engine.filter((file) => fs.existsSync(file))])) return output;
+
+  fs.mkdirSync(outDir, { recursive: true });
+  console.error(`Building ${path.relative(root, output)}`);
+  try {
+    execFileSync('emcc', [
+      '-std=c++20', source, '-o', output, '-O3',
+      '-s', 'WASM=1', '-s', 'MODULARIZE=1', '-s', 'EXPORT_NAME=createAlgoModule',
+      '-s', 'EXPORTED_RUNTIME_METHODS=["cwrap","HEAP8"]', '-s', 'ALLOW_MEMORY_GROWTH=1',
+      '--bind', '-I', path.join(root, 'src/cpp'),
+    ], { stdio: 'inherit' });
+  } catch (e) {
+    if (e.code === 'ENOENT') throw new Error('emcc not found: activate the Emscripten SDK, or pass --no-build with built modules');
+    throw e;
+  }
+  return output;
+}
+
+// The module exports its memory under different names depending on the emcc version
+function wasmMemoryBytes(Module) {
+  const buffer = (Module.HEAP8 && Module.HEAP8.buffer)
+    || (Module.wasmMemory && Module.wasmMemory.buffer)
+    || (Module.wasmExports && Module.wasmExports.memory && Module.wasmExports.memory.buffer);
+  return buffer ? buffer.byteLength : NaN;
+}
+
+const msSince = (started) => Number(process.hrtime.bigint() - started) / 1e6;
+
+// One fresh instance, one run: the first press of the button on a freshly loaded page
+async function measureOnce(createAlgoModule, input) {
+  let started = process.hrtime.bigint();
+  const Module = await createAlgoModule();
+  const instantiateMs = msSince(started);
+
+  started = process.hrtime.bigint();
+  const payload = Module.visualizeMyLogic(input);
+  const runMs = msSince(started);
+  const peakBytes = wasmMemoryBytes(Module);
+
+  started = process.hrtime.bigint();
+  const history = JSON.parse(payload);
+  const parseMs = msSince(started);
+  if (!Array.isArray(history)) throw new Error('visualizeMyLogic did not return an array of frames');
+
+  // Parse errors and exceptions end the history with an "Error: ..." frame
+  const last = history[history.length - 1];
+  const error = last && typeof last.message === 'string' && last.message.startsWith('Error: ') ? last.message : null;
+  return { instantiateMs, runMs, payloadBytes: payload.length, parseMs, peakBytes, frames: history.length, error };
+}
+
+function median(values) {
+  const sorted = values.filter((value) => !Number.isNaN(value)).sort((a, b) => a - b);
+  return sorted.length ? sorted[Math.floor((sorted.length - 1) / 2)] : NaN;
+}
+
+const mb = (bytes) => (Number.isNaN(bytes) ? '?' : (bytes / 1048576).toFixed(1));
+
+function printRow(columns) {
+  const widths = [16, 8, 12, 10, 11, 10, 10, 8];
+  console.log(columns.map((column, i) => String(column)[i < 1 ? 'padEnd' : 'padStart'](widths[i])).join(' '));
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const selected = corpus.filter((algorithm) => algorithm.name.includes(options.only));
+  if (selected.length === 0) throw new Error(`No algorithm matches '${options.only}'`);
+
+  const results = [];
+  let failures = 0;
+  printRow(['algorithm', 'size', 'instantiate', 'run', 'payload', 'parse', 'peak mem', 'frames']);
+  printRow(['', '', 'ms', 'ms', 'MB', 'ms', 'MB', '']);
+  for (const algorithm of selected) {
+    const modulePath = options.build ? buildModule(algorithm.name, options.out) : path.join(options.out, `${algorithm.name}.js`);
+    const createAlgoModule = require(modulePath);
+
+    for (const size of algorithm.sizes) {
+      const input = algorithm.input(size, mulberry32(size));
+      const runs = [];
+      let failure = null;
+      for (let i = 0; i < options.runs && !failure; i += 1) {
+        try {
+          const run = await measureOnce(createAlgoModule, input);
+          if (run.error) failure = run.error;
+          runs.push(run);
+        } catch (e) {
+          // An abort (e.g. running out of wasm memory) leaves the instance unusable; report it and move on
+          failure = e && e.message ? e.message : String(e);
+        }
+      }
+
+      const result = { algorithm: algorithm.name, size, inputBytes: input.length, runs };
+      for (const key of ['instantiateMs', 'runMs', 'payloadBytes', 'parseMs', 'peakBytes', 'frames']) {
+        result[key] = median(runs.map((run) => run[key]));
+      }
+      if (failure) result.error = failure, failures += 1;
+      results.push(result);
+
+      if (failure && runs.length === 0) {
+        printRow([algorithm.name, size, 'FAILED', '', '', '', '', '']);
+      } else {
+        printRow([algorithm.name, size, result.instantiateMs.toFixed(1), result.runMs.toFixed(1), mb(result.payloadBytes),
+          result.parseMs.toFixed(1), mb(result.peakBytes), result.frames]);
+      }
+      if (failure) console.error(`  ${algorithm.name} at size ${size}: ${failure}`);
+    }
+  }
+
+  if (options.json) fs.writeFileSync(options.json, JSON.stringify(results, null, 2) + '\n');
+  if (failures > 0) process.exit(1);
+}
+
+main().catch((e) => {
+  console.error(`bench-e2e: ${e.message}`);
+  process.exit(1);
+});
@@ -0,0 +1,55 @@
+// Runs the compiled engine (public/wasm/algorithms.js) in Node and streams the history of one input.
+//
+// Usage: node scripts/stream-history.js [input-file] [frames-per-chunk] [json|binary] > history.ndjson
+//   input-file        Universal input, read from stdin when omitted or "-"
+//   frames-per-chunk  Frames per streamed chunk (default 500)
+//   json|binary       Streaming format (default json). Binary chunks are decoded with src/historyDecoder.js.
+//
+// Every chunk is written to stdout as one line (a JSON array of frames). A summary goes to stderr,
+// and the exit code is non-zero if a chunk does not decode or the frame count does not add up.
+const fs = require('fs');
+const path = require('path');
+
+const createAlgoModule = require(path.resolve(__dirname, '../public/wasm/algorithms.js'));
+
+const inputFile = process.argv[2] && process.argv[2] !== '-' ? process.argv[2] : 0;
+const framesPerChunk = Number(process.argv[3] || 500);
+const binary = process.argv[4] === 'binary';
+const rawInput = fs.readFileSync(inputFile, 'utf8');
+
+// The decoder is an ES module written for the React app; load it without a bundler
+function loadDecoder() {
+  const source = fs.readFileSync(path.resolve(__dirname, '../src/historyDecoder.js'), 'utf8');
+  return import('data:text/javascript,' + encodeURIComponent(source));
+}
+
+Promise.all([createAlgoModule(), binary ? loadDecoder() : null]).then(([Module, decoderModule]) => {
+  const decoder = binary ? new decoderModule.HistoryDecoder() : null;
+  let chunks = 0;
+  let frames = 0;
+  let bytes = 0;
+  let largestChunk = 0;
+
+  const onChunk = (chunk) => {
+    const parsed = binary ? decoder.decodeChunk(chunk) : JSON.parse(chunk);
+    if (!Array.isArray(parsed) || parsed.length === 0 || parsed.length > framesPerChunk) {
+      throw new Error(`Chunk ${chunks} is not an array of 1..${framesPerChunk} frames`);
+    }
+    chunks += 1;
+    frames += parsed.length;
+    bytes += chunk.length;
+    largestChunk = Math.max(largestChunk, chunk.length);
+    process.stdout.write((binary ? JSON.stringify(parsed) : chunk) + '\n');
+  };
+
+  const started = process.hrtime.bigint();
+  const run = binary ? Module.visualizeMyLogicStreamingBinary : Module.visualizeMyLogicStreaming;
+  const reported = run(rawInput, onChunk, framesPerChunk);
+  const elapsedMs = Number(process.hrtime.bigint() - started) / 1e6;
+
+  console.error(`${frames} frames in ${chunks} chunks, ${bytes} bytes (largest chunk ${largestChunk} bytes), ${elapsedMs.toFixed(1)} ms`);
+  if (reported !== frames) {
+    console.error(`Frame count mismatch: engine reported ${reported}, received ${frames}`);
+    process.exit(1);
+  }
+});
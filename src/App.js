@@ -1,6 +1,10 @@
-import React, { useState, useEffect, useRef, useCallback } from 'react';
+import React, { useState, useEffect, useRef, useCallback, useMemo } from 'react';
 import './App.css';
 import { FaPlay, FaPause, FaStepBackward, FaStepForward } from 'react-icons/fa';
+import { HistoryDecoder } from './historyDecoder';
+
+// Number of frames the Wasm engine hands over per streamed chunk
+const FRAMES_PER_CHUNK = 500;
 
 // --- MAIN APP COMPONENT (FINAL UNIVERSAL VERSION) ---
 function App() {
@@ -8,6 +12,7 @@ function App() {
   const [rawInput, setRawInput] = useState('');
   const [wasmModule, setWasmModule] = useState(null);
   const visualizeMyLogicRef = useRef(null);
+  const visualizeStreamingRef = useRef(null);
   const [history, setHistory] = useState([]);
   const [currentFrameIndex, setCurrentFrameIndex] = useState(0);
   const [isPlaying, setIsPlaying] = useState(false);
@@ -18,6 +23,7 @@ function App() {
       window.createAlgoModule().then(Module => {
         setWasmModule(Module);
         visualizeMyLogicRef.current = Module.visualizeMyLogic;
+        visualizeStreamingRef.current = Module.visualizeMyLogicStreamingBinary;
       });
     }
   }, []);
@@ -29,16 +35,26 @@ function App() {
     setIsGenerating(true); setIsPlaying(false);
     setTimeout(() => {
       // --- The only thing React does is pass the raw string ---
-      let historyJson = '';
+      // Frames come back in small binary chunks, so neither side ever holds the whole history at once,
+      // and unchanged objects are shared between frames instead of being parsed again.
+      let parsedHistory = null;
       try {
-        historyJson = funcToRun(rawInput);
+        const streamToRun = visualizeStreamingRef.current;
+        if (streamToRun) {
+          const decoder = new HistoryDecoder();
+          parsedHistory = [];
+          streamToRun(rawInput, (chunk) => {
+            for (const frame of decoder.decodeChunk(chunk)) parsedHistory.push(frame);
+          }, FRAMES_PER_CHUNK);
+        } else {
+          parsedHistory = JSON.parse(funcToRun(rawInput));
+        }
       } catch (e) {
         console.error("Error from C++ execution:", e);
         alert("An error occurred in the C++ code. Check the console.");
       }
 
-      if (historyJson) {
-        const parsedHistory = JSON.parse(historyJson);
+      if (parsedHistory && parsedHistory.length > 0) {
         setHistory(parsedHistory);
         setCurrentFrameIndex(0);
       }
@@ -131,7 +147,7 @@ auto total = v.get_scalar<int>("count");
           </div>
         )}
         <div className="visualization-area">
-          <div className="status-message">{currentFrame.message}</div>
+          <div className="status-message">{currentFrame.message}{currentFrame.dropped > 0 && <span className="dropped-note"> ({currentFrame.dropped} steps skipped)</span>}</div>
           <div className="objects-grid">{objectEntries.map(([name, obj]) => (<VisualObject key={name} name={name} obj={obj} />))}</div>
         </div>
       </main>
@@ -162,14 +178,40 @@ const VisualObject = ({ name, obj }) => (
 const ScalarView = ({ data, highlights }) => <div className="array-cell scalar-cell" data-state={highlights?.['0'] || 'default'}>{data}</div>;
 const StringView = ({ data, highlights }) => <div className="array-cell string-cell" data-state={highlights?.['0'] || 'default'}>"{data}"</div>;
 const BoolView = ({ data, highlights }) => <div className="array-cell scalar-cell" data-state={highlights?.['0'] || 'default'}>{data ? 'true' : 'false'}</div>;
-const VectorView = ({ data, highlights }) => <div className="vector-wrapper">{data.map((value, idx) => (<div className="cell-block" key={idx}><div className="array-cell" data-state={highlights?.[`${idx}`] || 'default'}>{value}</div><div className="cell-index">{idx}</div></div>))}</div>;
+// The state of element `idx`: its own highlight, or a "first:last" range that covers it
+const indexState = (highlights, idx) => {
+  if (highlights?.[`${idx}`]) return highlights[`${idx}`];
+  for (const [key, state] of Object.entries(highlights || {})) {
+    const [first, last] = key.split(':');
+    if (last !== undefined && idx >= +first && idx <= +last) return state;
+  }
+  return 'default';
+};
+const VectorView = ({ data, highlights }) => <div className="vector-wrapper">{data.map((value, idx) => (<div className="cell-block" key={idx}><div className="array-cell" data-state={indexState(highlights, idx)}>{value}</div><div className="cell-index">{idx}</div></div>))}</div>;
 const SetView = ({ data, highlights }) => { const sortedData = Array.isArray(data) ? [...data].sort((a, b) => a - b) : []; return <div className="set-wrapper">{sortedData.map((value, idx) => (<div className="array-cell" key={idx} data-state={highlights?.[`${value}`] || 'default'}>{value}</div>))}</div> };
-const MatrixView = ({ data, highlights }) => <div className="matrix-grid">{(Array.isArray(data) ? data : []).map((row, r_idx) => (<div className="matrix-row" key={r_idx}>{row.map((value, c_idx) => (<div className="array-cell" key={c_idx} data-state={highlights?.[`${r_idx}-${c_idx}`] || 'default'}>{value}</div>))}</div>))}</div>;
-const MapView = ({ data, highlights }) => <div className="map-wrapper">{(Array.isArray(data) ? data : []).sort((a, b) => a.key - b.key).map(({ key, value }, idx) => (<div className="map-pair" key={idx}><div className="array-cell map-key">{key}</div><div className="map-separator">→</div><div className="array-cell map-value" data-state={highlights?.[`${key}`] || 'default'}>{value}</div></div>))}</div>;
-const StackView = ({ data, highlights }) => <div className="stack-wrapper"><div className="stack-top-label">TOP</div>{(Array.isArray(data) ? [...data] : []).reverse().map((value, idx) => (<div className="array-cell" key={idx} data-state={idx === 0 ? highlights?.['top'] : 'default'}>{value}</div>))}</div>;
+// Matrices arrive as { rows, cols, cells } with the cells flat and row-major. Highlight keys are
+// "r-c" (a cell), "r-*" (a row), "*-c" (a column) or "r0-c0:r1-c1" (a rectangle, corners included).
+const matrixCellState = (highlights) => {
+  const rows = {}, cols = {}, regions = [];
+  for (const [key, state] of Object.entries(highlights || {})) {
+    const [from, to] = key.split(':');
+    const [r, c] = from.split('-');
+    if (to !== undefined) { const [r1, c1] = to.split('-'); regions.push({ r0: +r, c0: +c, r1: +r1, c1: +c1, state }); }
+    else if (c === '*') rows[r] = state;
+    else if (r === '*') cols[c] = state;
+  }
+  return (r, c) => highlights?.[`${r}-${c}`] || rows[r] || cols[c] || regions.find(g => r >= g.r0 && r <= g.r1 && c >= g.c0 && c <= g.c1)?.state || 'default';
+};
+const MatrixView = ({ data, highlights }) => { const stateOf = useMemo(() => matrixCellState(highlights), [highlights]); const { rows = 0, cols = 0, cells = [] } = data || {}; return <div className="matrix-grid">{Array.from({ length: rows }, (_, r_idx) => (<div className="matrix-row" key={r_idx}>{Array.from({ length: cols }, (_, c_idx) => (<div className="array-cell" key={c_idx} data-state={stateOf(r_idx, c_idx)}>{cells[r_idx * cols + c_idx]}</div>))}</div>))}</div> };
+// Maps arrive columnar, { keys, values }; unordered ones are shown in key order too
+const MapView = ({ data, highlights }) => { const order = useMemo(() => { const keys = data?.keys || []; return keys.map((_, idx) => idx).sort((a, b) => (keys[a] < keys[b] ? -1 : keys[a] > keys[b] ? 1 : a - b)); }, [data]); return <div className="map-wrapper">{order.map((idx) => (<div className="map-pair" key={idx}><div className="array-cell map-key">{data.keys[idx]}</div><div className="map-separator">→</div><div className="array-cell map-value" data-state={highlights?.[`${data.keys[idx]}`] || 'default'}>{data.values[idx]}</div></div>))}</div> };
+// The engine sends the stack bottom to top; column-reverse stacks it up from the closed end, so the
+// last element (the top) sits at the open end, under the label
+const StackView = ({ data, highlights }) => <div className="stack-wrapper">{(Array.isArray(data) ? data : []).map((value, idx) => (<div className="array-cell" key={idx} data-state={(idx === data.length - 1 ? highlights?.['top'] : 'default') || 'default'}>{value}</div>))}<div className="stack-top-label">TOP</div></div>;
 const QueueView = ({ data, highlights }) => <div className="queue-wrapper"><div className="queue-label">FRONT</div>{(Array.isArray(data) ? data : []).map((value, idx) => (<div className="array-cell" key={idx} data-state={(idx === 0 ? highlights?.['front'] : (idx === data.length - 1 ? highlights?.['back'] : 'default')) || 'default'}>{value}</div>))}<div className="queue-label">BACK</div></div>;
-const PriorityQueueView = ({ data, highlights }) => <div className="pq-wrapper"><div className="pq-top-label">MAX HEAP (TOP)</div>{(Array.isArray(data) ? [...data] : []).sort((a, b) => b - a).map((value, idx) => (<div className="array-cell pq-cell" key={idx} data-state={idx === 0 ? highlights?.['top'] : 'default'}>{value}</div>))}</div>;
+// The engine sends the heap in its array order; sort it into pop order once per data, not per render
+const PriorityQueueView = ({ data, highlights }) => { const popOrder = useMemo(() => (Array.isArray(data) ? [...data] : []).sort((a, b) => b - a), [data]); return <div className="pq-wrapper"><div className="pq-top-label">MAX HEAP (TOP)</div>{popOrder.map((value, idx) => (<div className="array-cell pq-cell" key={idx} data-state={idx === 0 ? highlights?.['top'] : 'default'}>{value}</div>))}</div> };
 const PairView = ({ data, highlights }) => <div className="pair-wrapper"><div className="array-cell" data-state={highlights?.['0'] || 'default'}>{data?.[0]}</div><div className="array-cell" data-state={highlights?.['1'] || 'default'}>{data?.[1]}</div></div>;
-const TupleView = ({ data, highlights }) => <div className="tuple-wrapper">{(Array.isArray(data) ? data : []).map((value, idx) => <div className="array-cell" key={idx} data-state={highlights?.[`${idx}`] || 'default'}>{value}</div>)}</div>;
+const TupleView = ({ data, highlights }) => <div className="tuple-wrapper">{(Array.isArray(data) ? data : []).map((value, idx) => <div className="array-cell" key={idx} data-state={indexState(highlights, idx)}>{value}</div>)}</div>;
 
 export default App;
\ No newline at end of file
@@ -10,11 +10,14 @@
 // ==========================================================
 #include <iostream>   // For std::cout, std::cin (console debugging)
 #include <string>     // For std::string
+#include <string_view> // For std::string_view
 #include <vector>     // For std::vector
 #include <utility>    // For std::pair, std::move, std::forward
 #include <stdexcept>  // For standard exception classes like std::runtime_error
 #include <chrono>     // For time-related operations and benchmarking
 #include <memory>     // For smart pointers like std::unique_ptr, std::shared_ptr
+#include <memory_resource> // For std::pmr memory resources and allocators
+#include <optional>   // For std::optional
 #include <functional> // For std::function and other functional utilities
 
 // ==========================================================
@@ -22,6 +25,7 @@
 // ==========================================================
 #include <algorithm>  // For std::sort, std::find, std::min, std::max, etc.
 #include <numeric>    // For std::accumulate, std::iota, std::gcd, std::lcm
+#include <charconv>   // For std::to_chars / std::from_chars number formatting
 #include <cmath>      // For math functions (sqrt, pow, sin, cos, etc.)
 #include <cstdlib>    // For general utilities like abs(), rand(), srand()
 #include <cctype>     // For character functions (toupper, isdigit, isalpha)
@@ -0,0 +1,162 @@
+// ########## Native Runner: v-cpp without Emscripten ##########
+// Runs run_my_algorithm (from algorithms.cpp, or the file CMake's V_CPP_ALGORITHM names) on a
+// universal input and writes the history, so the engine can be profiled with perf, heap
+// profilers and sanitizers on real workloads.
+//
+// Usage: v-cpp-run [options] [input-file]     (the input is read from stdin when omitted or "-")
+//   -o, --output FILE          Write to FILE instead of stdout
+//   -f, --format json|binary|profile
+//                              json:    the history visualizeMyLogic returns (default)
+//                              binary:  the same history in the VCPB format (visualizeMyLogicBinary)
+//                              profile: operation counts only, no frames (visualizeMyLogicProfile)
+//   -b, --budget N             Frame budget (default 20000, 0 = unlimited)
+//   -s, --stream N             Write the history in chunks of N frames while the algorithm runs,
+//                              one JSON array per line (or binary chunks back to back)
+//   -t, --time                 Print the frame count, run time and output size to stderr
+//   -m, --memory               Print what the history took in memory to stderr (VizEngine::dump_stats)
+
+#include "v-cpp.hpp"
+
+namespace
+{
+struct RunnerOptions
+{
+    string input_path = "-";
+    string output_path = "-";
+    string format = "json";
+    int budget = VizEngine::default_frame_budget;
+    int stream = 0;
+    bool time = false;
+    bool memory = false;
+};
+
+[[noreturn]] void usage_error(const string &message)
+{
+    throw runtime_error(message + "\nUsage: v-cpp-run [-o FILE] [-f json|binary|profile] [-b N] [-s N] [-t] [-m] [input-file]");
+}
+
+int parse_count(const string &option, const char *value)
+{
+    char *end = nullptr;
+    long n = value ? strtol(value, &end, 10) : -1;
+    if (!value || *end != '\0' || n < 0 || n > INT_MAX)
+        usage_error("Option " + option + " needs a count.");
+    return static_cast<int>(n);
+}
+
+RunnerOptions parse_options(int argc, char **argv)
+{
+    RunnerOptions options;
+    bool have_input = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "-o" || arg == "--output")
+        {
+            if (!value)
+                usage_error("Option " + arg + " needs a file name.");
+            options.output_path = value, ++i;
+        }
+        else if (arg == "-f" || arg == "--format")
+        {
+            if (!value || (string(value) != "json" && string(value) != "binary" && string(value) != "profile"))
+                usage_error("Option " + arg + " needs json, binary or profile.");
+            options.format = value, ++i;
+        }
+        else if (arg == "-b" || arg == "--budget")
+            options.budget = parse_count(arg, value), ++i;
+        else if (arg == "-s" || arg == "--stream")
+            options.stream = parse_count(arg, value), ++i;
+        else if (arg == "-t" || arg == "--time")
+            options.time = true;
+        else if (arg == "-m" || arg == "--memory")
+            options.memory = true;
+        else if (arg.size() > 1 && arg[0] == '-')
+            usage_error("Unknown option " + arg + ".");
+        else if (have_input)
+            usage_error("Only one input file can be given.");
+        else
+            options.input_path = arg, have_input = true;
+    }
+    if (options.stream > 0 && options.format == "profile")
+        usage_error("A profile has no frames to stream.");
+    return options;
+}
+
+string read_input(const string &path)
+{
+    stringstream text;
+    if (path == "-")
+    {
+        text << cin.rdbuf();
+        return text.str();
+    }
+    ifstream file(path, ios::binary);
+    if (!file)
+        throw runtime_error("Cannot read input file '" + path + "'.");
+    text << file.rdbuf();
+    return text.str();
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        RunnerOptions options = parse_options(argc, argv);
+        string input = read_input(options.input_path);
+
+        ofstream file;
+        if (options.output_path != "-")
+        {
+            file.open(options.output_path, ios::binary);
+            if (!file)
+                throw runtime_error("Cannot write output file '" + options.output_path + "'.");
+        }
+        ostream &out = options.output_path != "-" ? file : cout;
+
+        auto start = chrono::steady_clock::now();
+        size_t bytes = 0;
+        int frames = 0;
+        if (options.stream > 0)
+        {
+            bool binary = options.format == "binary";
+            frames = visualizeMyLogicStreamingTo(input, [&](const string &chunk)
+                                                 {
+                                                     out << chunk;
+                                                     if (!binary)
+                                                         out << '\n';
+                                                     bytes += chunk.size(); },
+                                                 options.stream, binary ? HistoryFormat::Binary : HistoryFormat::Json, options.budget);
+        }
+        else
+        {
+            string result = options.format == "binary"    ? visualizeMyLogicBinaryString(input, options.budget)
+                            : options.format == "profile" ? visualizeMyLogicProfile(input)
+                                                          : visualizeMyLogicWithBudget(input, options.budget);
+            frames = static_cast<int>(viz.frame_count());
+            out << result;
+            if (options.format != "binary")
+                out << '\n';
+            bytes = result.size();
+        }
+        out.flush();
+        if (!out)
+            throw runtime_error("Writing the output failed.");
+
+        if (options.time)
+        {
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            fprintf(stderr, "%d frames, %zu bytes, %.1f ms\n", frames, bytes, ms);
+        }
+        if (options.memory)
+            fprintf(stderr, "%s\n", viz.dump_stats().c_str());
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "v-cpp-run: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,49 @@
+// ########## Prebuilt Engine: v-cpp.o ##########
+// Compiles the engine, the serializer, the input parser and the bindings once, so that editing
+// an algorithm only recompiles the algorithm. Build it once per emcc (or compiler) version:
+//
+//   emcc -std=c++20 -O3 -c src/cpp/v-cpp.cpp -o v-cpp.o -I src/cpp
+//   emcc -std=c++20 -DV_CPP_PREBUILT src/cpp/algorithms.cpp v-cpp.o -o public/algo.js -O3 ... --bind -I src/cpp
+//
+// The algorithm must be compiled with -DV_CPP_PREBUILT and the same V_CPP_NO_RECORDING setting.
+
+#ifndef V_CPP_PREBUILT
+#define V_CPP_PREBUILT
+#endif
+
+#include "v-cpp.hpp"
+#include "v-cpp/engine.hpp"
+#include "v-cpp/serializer.hpp"
+#include "v-cpp/parser.hpp"
+#include "v-cpp/bindings.hpp"
+
+VizEngine viz;
+
+// --- The input types VCtx can read ---
+// VCtx::input is only defined here, so a prebuilt algorithm can read its inputs as these element
+// types. Reading any other type is a link error: build that algorithm header-only instead.
+#define V_CPP_INPUT_TYPES(T)                                                         \
+    template T VCtx::input<T>(const string &) const;                                 \
+    template vector<T> VCtx::input<vector<T>>(const string &) const;                 \
+    template vector<vector<T>> VCtx::input<vector<vector<T>>>(const string &) const; \
+    template list<T> VCtx::input<list<T>>(const string &) const;                     \
+    template deque<T> VCtx::input<deque<T>>(const string &) const;
+
+#define V_CPP_INPUT_PAIRS(K, V) template vector<pair<K, V>> VCtx::input<vector<pair<K, V>>>(const string &) const;
+#define V_CPP_INPUT_PAIRS_WITH(K)   \
+    V_CPP_INPUT_PAIRS(K, int)       \
+    V_CPP_INPUT_PAIRS(K, long long) \
+    V_CPP_INPUT_PAIRS(K, double)    \
+    V_CPP_INPUT_PAIRS(K, string)
+
+V_CPP_INPUT_TYPES(int)
+V_CPP_INPUT_TYPES(long long)
+V_CPP_INPUT_TYPES(double)
+V_CPP_INPUT_TYPES(string)
+V_CPP_INPUT_TYPES(bool)
+V_CPP_INPUT_TYPES(char)
+
+V_CPP_INPUT_PAIRS_WITH(int)
+V_CPP_INPUT_PAIRS_WITH(long long)
+V_CPP_INPUT_PAIRS_WITH(double)
+V_CPP_INPUT_PAIRS_WITH(string)
@@ -2,123 +2,1490 @@
 #define V_CPP_HPP
 
 // ########## C++ Visualization Framework - By Saumy Tiwari ##########
-// This is the header-only library file. Include this in your project to use the framework.
+// This is the library file. Include this in your project to use the framework.
+// By default it is header-only: the engine, the JSON serializer, the input parser and the
+// bindings (src/cpp/v-cpp/) are compiled along with your algorithm. Build with -DV_CPP_PREBUILT
+// and link v-cpp.o (compiled once from src/cpp/v-cpp.cpp) to only recompile your algorithm.
 
 #include "libraries.hpp"
-#include <emscripten/bind.h>
-#include "include/nlohmann/json.hpp"
 
 using namespace std;
-using json = nlohmann::json;
+
+// --- Prebuilt engine switch ---
+// The out-of-line definitions in src/cpp/v-cpp/ are inline in the header-only build, and plain
+// functions of v-cpp.o in the prebuilt one.
+#ifdef V_CPP_PREBUILT
+#define V_CPP_INLINE
+#else
+#define V_CPP_INLINE inline
+#endif
+
+// --- Recording switch ---
+// Build with -DV_CPP_NO_RECORDING and every wrapper compiles down to the plain container it holds:
+// each call a wrapper makes into `viz` sits in V_RECORD, which discards it at compile time,
+// arguments included. The same run_my_algorithm can then be timed at native speed (see
+// bench/recording_off.cpp). The engine itself still works, so parse errors, exceptions and
+// your own viz.log_frame calls are still reported.
+#ifdef V_CPP_NO_RECORDING
+inline constexpr bool viz_recording = false;
+#else
+inline constexpr bool viz_recording = true;
+#endif
+#define V_RECORD(...)                   \
+    do                                  \
+    {                                   \
+        if constexpr (viz_recording)    \
+        {                               \
+            __VA_ARGS__;                \
+        }                               \
+    } while (false)
+
+// --- How the engine stores its frames ---
+// Full:  every frame owns a complete copy of every object's state (the original behaviour).
+// Delta: every `keyframe_interval`-th frame is a full keyframe, all other frames only keep
+//        the objects that changed since the previous frame. The full frames are rebuilt on export.
+enum class HistoryMode
+{
+    Full,
+    Delta
+};
+
+// --- Which of an object's operations make frames of their own ---
+// Whatever the level, the object's changes are still applied and it shows its current state in
+// every frame; a quieter level only stops it from logging frames (and highlights) itself.
+enum class VizLevel : uint8_t
+{
+    Full,           // every read, compare, write, insert and erase
+    WritesOnly,     // writes and structural changes, no reads or compares
+    StructuralOnly, // creation, whole assignments, inserts and erases, no element writes (m[key] = value is one)
+    Silent          // none at all
+};
+
+// --- A single container mutation, recorded instead of re-serializing the whole container ---
+enum class VizOpKind
+{
+    PushBack,         // append `value`
+    PushFront,        // prepend `value`
+    PopBack,          // remove the last element
+    PopFront,         // remove the first element
+    SetAt,            // replace the element at `index` with `value` (matrices: the flat row-major index)
+    InsertSorted,     // insert `value` after every element <= it (set / multiset order)
+    EraseValue,       // remove the first element equal to `value`
+    SetKey,           // replace the entry whose key is `key` with the entry `value`, or insert it in key order
+    InsertKey,        // insert the entry `value` after every entry whose key is <= `key` (multimap order)
+    Clear             // remove every element
+};
+
+// Keys and values are serialized with VizValueWriter (VizEngine::encode_value).
+struct VizOp
+{
+    VizOpKind kind;
+    size_t index = 0;  // SetAt
+    string key = {};   // The map key, for SetKey and InsertKey
+    string value = {}; // The element or entry written, when the op needs one
+};
+
+// --- What an op did to the exported data, with its position resolved ---
+// Produced while replaying ops on export, so a decoder can apply them without knowing
+// how sets, maps or priority queues order their elements.
+enum class VizEditKind : uint8_t
+{
+    Insert, // insert `value` before `index`
+    Erase,  // remove the element at `index`
+    Set,    // replace the element at `index` with `value`
+    Clear   // remove every element
+};
+
+struct VizEdit
+{
+    VizEditKind kind;
+    size_t index = 0;
+    string value = {}; // Serialized
+};
+
+// Heap bytes behind a string (std or pmr), nothing when it is short enough to live inside it
+template <typename S>
+size_t viz_heap_bytes(const S &s)
+{
+    auto at = reinterpret_cast<const char *>(s.data()), self = reinterpret_cast<const char *>(&s);
+    return at >= self && at < self + sizeof(S) ? 0 : s.capacity() + 1;
+}
+
+// --- Interned strings ---
+// Object names, type tags, highlight keys and states, and messages repeat in almost every frame.
+// The engine keeps each distinct string once and refers to it by id everywhere else.
+class VizStringTable
+{
+public:
+    // Looking up a string that is already in the table does not allocate
+    uint32_t intern(string_view s)
+    {
+        auto it = ids.find(s);
+        if (it == ids.end())
+        {
+            it = ids.emplace(string(s), static_cast<uint32_t>(strings.size())).first;
+            strings.push_back(&it->first);
+            entry_bytes += node_size + viz_heap_bytes(it->first);
+        }
+        return it->second;
+    }
+
+    const string &operator[](uint32_t id) const { return *strings[id]; }
+    size_t size() const { return strings.size(); }
+
+    // What the table holds on the heap: its entries, the hash buckets and the id index
+    size_t bytes() const
+    {
+        return entry_bytes + ids.bucket_count() * sizeof(void *) + strings.capacity() * sizeof(const string *);
+    }
+
+    void clear()
+    {
+        ids.clear();
+        strings.clear();
+        entry_bytes = 0;
+    }
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+    };
+
+    unordered_map<string, uint32_t, Hash, equal_to<>> ids;
+    vector<const string *> strings; // Points at the keys of `ids`, which never move
+    size_t entry_bytes = 0;
+
+    // A hash node: next pointer, key, id and the cached hash
+    static constexpr size_t node_size = sizeof(void *) + sizeof(string) + sizeof(uint32_t) + sizeof(size_t);
+};
+
+// Characters are logged and highlighted as the text they stand for, not as their codes
+template <typename T>
+inline constexpr bool viz_is_char = is_same_v<T, char> || is_same_v<T, signed char> || is_same_v<T, unsigned char>;
+
+// --- One argument of a log message ---
+// Messages are logged as a template ("Pushed {} to '{}'") plus typed arguments, and only turned
+// into text on export. Strings are interned, so an argument is a fixed-size value.
+struct VizArg
+{
+    enum Kind : uint8_t
+    {
+        Int,
+        Unsigned,
+        Double,
+        String
+    } kind;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint32_t s; // Interned
+    };
+};
+
+// --- Per-run storage for frames and snapshots ---
+// Everything a run records is carved out of one block that is kept from run to run, instead of
+// being a separate heap allocation. A pool on top recycles what is freed during the run (streamed
+// frames, replaced snapshots), and reset() drops the whole run at once. If a run needs more than
+// the block, the extra comes from the heap and the block grows to fit it for the next run.
+class VizRunArena : public pmr::memory_resource
+{
+public:
+    static constexpr size_t initial_size = 256 * 1024;
+    static constexpr size_t max_retained_size = 64 * 1024 * 1024;
+
+    VizRunArena() : block(initial_size) { start(); }
+
+    // Only call this once nothing allocated from the arena is in use anymore
+    void reset()
+    {
+        pool.reset();
+        buffer.reset();
+        size_t wanted = min(block.size() + overflow.allocated, max_retained_size);
+        if (wanted > block.size())
+        {
+            block = vector<byte>(wanted);
+        }
+        overflow.allocated = 0;
+        start();
+    }
+
+    // Memory this run has taken so far: the block, plus whatever it needed from the heap beyond it
+    size_t reserved() const { return block.size() + overflow.allocated; }
+
+private:
+    // The heap, counting what the run took from it beyond the block
+    struct Overflow : pmr::memory_resource
+    {
+        size_t allocated = 0;
+
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            allocated += bytes;
+            return pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    vector<byte> block;
+    Overflow overflow;
+    optional<pmr::monotonic_buffer_resource> buffer;
+    optional<pmr::unsynchronized_pool_resource> pool;
+
+    void start()
+    {
+        buffer.emplace(block.data(), block.size(), &overflow);
+        pool.emplace(pmr::pool_options{0, 64 * 1024}, &*buffer);
+    }
+
+    void *do_allocate(size_t bytes, size_t alignment) override { return pool->allocate(bytes, alignment); }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override { pool->deallocate(p, bytes, alignment); }
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+// (key id, state id) pairs, sorted by key text
+using VizHighlightIds = pmr::vector<pair<uint32_t, uint32_t>>;
+
+// --- Highlights as wrappers record them ---
+// A wrapper marks what an operation touched with a few VizHighlights: plain values on the stack,
+// no strings and no heap. They only become the exported "key": "state" text when the object's
+// version is committed (VizEngine::commit), once per frame instead of once per operation.
+enum class VizState : uint8_t
+{
+    Read,
+    Write,
+    Compare
+};
+
+inline const char *state_name(VizState state)
+{
+    switch (state)
+    {
+    case VizState::Write:
+        return "write";
+    case VizState::Compare:
+        return "compare";
+    default:
+        return "read";
+    }
+}
+
+struct VizHighlight
+{
+    enum Kind : uint8_t
+    {
+        Number, // an index or integer key                  "a"
+        Real,   // a floating point key                       "1.5"
+        Text,   // a string key or a name ("top", "front")    the text itself
+        Range,  // indexes a..b, both included                 "a:b"
+        Cell,   // matrix cell                                 "r-c"
+        Row,    // whole matrix row                            "r-*"
+        Col,    // whole matrix column                         "*-c"
+        Region  // matrix rectangle, corners included          "r0-c0:r1-c1"
+    };
+
+    Kind kind = Number;
+    VizState state = VizState::Read;
+    int64_t at[4] = {}; // Number, Range, Cell, Row, Col and Region coordinates; Text: the interned id once recorded
+    double real = 0;
+    string_view text; // Text, until the engine interns it (it only has to live for the call that records it)
+
+    VizHighlight() = default;
+
+    // Any key or index: integers, floating point numbers, characters and strings
+    template <typename K>
+    VizHighlight(const K &key, VizState s) : state(s)
+    {
+        if constexpr (viz_is_char<K>)
+            kind = Text, text = string_view(reinterpret_cast<const char *>(&key), 1);
+        else if constexpr (is_integral_v<K>)
+            at[0] = static_cast<int64_t>(key);
+        else if constexpr (is_floating_point_v<K>)
+            kind = Real, real = key;
+        else
+            kind = Text, text = string_view(key);
+    }
+
+    static VizHighlight make(Kind kind, VizState state, int64_t a, int64_t b = 0, int64_t c = 0, int64_t d = 0)
+    {
+        VizHighlight h;
+        h.kind = kind;
+        h.state = state;
+        h.at[0] = a, h.at[1] = b, h.at[2] = c, h.at[3] = d;
+        return h;
+    }
+    static VizHighlight range(size_t first, size_t last, VizState s) { return make(Range, s, first, last); }
+    static VizHighlight cell(size_t r, size_t c, VizState s) { return make(Cell, s, r, c); }
+    static VizHighlight row(size_t r, VizState s) { return make(Row, s, r); }
+    static VizHighlight col(size_t c, VizState s) { return make(Col, s, c); }
+    static VizHighlight region(size_t r0, size_t c0, size_t r1, size_t c1, VizState s) { return make(Region, s, r0, c0, r1, c1); }
+
+    static constexpr size_t max_key_chars = 4 * 21 + 3;
+
+    // The exported key text of any kind but Text, written into `buf` (max_key_chars bytes)
+    string_view format(char *buf) const
+    {
+        char *end = buf + max_key_chars, *p = buf;
+        auto number = [&](int64_t v) { p = to_chars(p, end, v).ptr; };
+        switch (kind)
+        {
+        case Real:
+            p = to_chars(p, end, real).ptr;
+            break;
+        case Range:
+            number(at[0]), *p++ = ':', number(at[1]);
+            break;
+        case Cell:
+            number(at[0]), *p++ = '-', number(at[1]);
+            break;
+        case Row:
+            number(at[0]), *p++ = '-', *p++ = '*';
+            break;
+        case Col:
+            *p++ = '*', *p++ = '-', number(at[0]);
+            break;
+        case Region:
+            number(at[0]), *p++ = '-', number(at[1]), *p++ = ':', number(at[2]), *p++ = '-', number(at[3]);
+            break;
+        default:
+            number(at[0]);
+            break;
+        }
+        return {buf, static_cast<size_t>(p - buf)};
+    }
+};
+
+// A handful of highlights stored inline. Wrappers never mark more than a few things per
+// operation; anything past `capacity` is dropped (use a Range, Row, Col or Region instead).
+class VizHighlights
+{
+public:
+    static constexpr size_t capacity = 4;
+
+    VizHighlights() = default;
+    VizHighlights(initializer_list<VizHighlight> list)
+    {
+        for (const auto &h : list)
+            push_back(h);
+    }
+
+    void push_back(const VizHighlight &h)
+    {
+        if (count < capacity)
+            items[count++] = h;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    VizHighlight *begin() { return items; }
+    VizHighlight *end() { return items + count; }
+    const VizHighlight *begin() const { return items; }
+    const VizHighlight *end() const { return items + count; }
+
+private:
+    VizHighlight items[capacity];
+    uint8_t count = 0;
+};
+
+// --- Memory accounting ---
+// What the recorded history holds, in bytes, kept up to date as the run goes. Every version of an
+// object reports its size when it is committed and takes it back when its last reference is gone,
+// so `snapshots` and the per-object numbers count the versions still alive: the ones frames point
+// at, the latest one of every object, and the full versions op versions are built on.
+// live() adds up what the history uses. footprint() is what the run takes from the heap for it:
+// the arena's blocks, which are carved up as needed and so are larger than what is in them, plus
+// the parts kept outside the arena. That is the number to hold against the Wasm memory limit.
+struct VizObjectMemory
+{
+    size_t live = 0;     // Bytes of this object's live versions
+    size_t peak = 0;     // The most they took at any point of the run
+    size_t versions = 0; // How many versions are alive
+};
+
+class VizMemoryStats
+{
+public:
+    size_t snapshots = 0;     // Every live version of every object
+    size_t frames = 0;        // The frames in the history and their message arguments
+    size_t strings = 0;       // The string table (names, types, highlight keys, messages)
+    size_t arena = 0;         // What the run arena took (see VizRunArena::reserved)
+    size_t outside_arena = 0; // The parts on the general heap: frame list, message arguments, strings, op values
+    size_t peak = 0;          // The highest footprint() reached during the run
+    size_t peak_frame = 0;    // Frames logged when it was reached
+
+    size_t live() const { return snapshots + frames + strings; }
+    size_t footprint() const { return arena + outside_arena; }
+
+    // Indexed by the interned object name; names that never had a version stay zero
+    const vector<VizObjectMemory> &objects() const { return by_name; }
+
+    // `op_values` of the `bytes` are op keys and values, which are not in the arena
+    void add(uint32_t name, size_t bytes, size_t op_values)
+    {
+        if (name >= by_name.size())
+            by_name.resize(name + 1);
+        auto &object = by_name[name];
+        object.live += bytes;
+        object.versions++;
+        object.peak = max(object.peak, object.live);
+        snapshots += bytes;
+        op_value_bytes += op_values;
+    }
+
+    void remove(uint32_t name, size_t bytes, size_t op_values)
+    {
+        by_name[name].live -= bytes;
+        by_name[name].versions--;
+        snapshots -= bytes;
+        op_value_bytes -= op_values;
+    }
+
+    size_t op_values() const { return op_value_bytes; }
+
+    void clear() { *this = {}; }
+
+private:
+    vector<VizObjectMemory> by_name;
+    size_t op_value_bytes = 0;
+};
+
+// --- An immutable, shared snapshot of one object's state ---
+// A new version is created only when the object itself is updated. Every frame that shows
+// this version of the object just holds another reference to the same snapshot.
+// A version either carries the full serialized `data`, or just the `ops` that turn its
+// `base` version into this one. Full data is only materialized every `keyframe_interval` versions,
+// or less often for large objects (see VizEngine::delta_limit).
+struct VizSnapshot
+{
+    uint32_t name = 0; // Interned
+    size_t version = 0;
+    uint32_t type = 0; // Interned
+    VizHighlightIds highlights;
+    bool full = true;
+    pmr::string data;                   // Full versions only, serialized with VizValueWriter
+    shared_ptr<const VizSnapshot> base; // Op versions only
+    pmr::vector<VizOp> ops;             // Op versions only
+    size_t depth = 0;                   // Op versions since the last full one
+    size_t full_size = 0;               // Bytes of data in the last full version
+    VizMemoryStats *memory = nullptr;   // Where its size was reported, to take it back when it goes
+    size_t bytes = 0, op_value_bytes = 0;
+
+    explicit VizSnapshot(pmr::memory_resource *arena) : highlights(arena), data(arena), ops(arena) {}
+    VizSnapshot(const VizSnapshot &) = delete;
+    VizSnapshot &operator=(const VizSnapshot &) = delete;
+    ~VizSnapshot()
+    {
+        if (memory)
+            memory->remove(name, bytes, op_value_bytes);
+    }
+
+    // Called once it is complete: its size is the snapshot in its shared_ptr control block (vtable,
+    // allocator, two counts) plus everything it points at
+    void report_to(VizMemoryStats &stats)
+    {
+        for (const auto &op : ops)
+            op_value_bytes += viz_heap_bytes(op.key) + viz_heap_bytes(op.value);
+        bytes = sizeof(VizSnapshot) + 2 * sizeof(void *) + 2 * sizeof(int) + highlights.capacity() * sizeof(highlights[0]) +
+                viz_heap_bytes(data) + ops.capacity() * sizeof(VizOp) + op_value_bytes;
+        memory = &stats;
+        stats.add(name, bytes, op_value_bytes);
+    }
+};
+using VizSnapshotPtr = shared_ptr<const VizSnapshot>;
+
+// A single recorded step of the algorithm
+struct VizFrame
+{
+    uint32_t message = 0; // Interned message template
+    uint32_t first_arg = 0; // The template's arguments are message_args[first_arg, first_arg + arg_count)
+    uint32_t arg_count = 0;
+    bool keyframe = false;
+    size_t dropped = 0; // Frames skipped by the frame budget right before this one
+    pmr::vector<VizSnapshotPtr> objects; // Every object on a keyframe, only the changed ones otherwise (sorted by name)
+
+    explicit VizFrame(pmr::memory_resource *arena) : objects(arena) {}
+};
+
+// --- Export formats ---
+// Json:   an array of full frames, the format the frontend has always consumed.
+// Binary: the compact "VCPB" format (see VizByteWriter and src/historyDecoder.js). Frames only carry
+//         the objects that changed, and ops are sent as positional edits instead of whole containers.
+enum class HistoryFormat
+{
+    Json,
+    Binary
+};
+
+// --- Low-level writer for the binary history format ---
+// All integers are LEB128 varints (signed ones zigzag-encoded first), doubles are 8 bytes little-endian.
+// Values are tagged; arrays made only of integers or only of numbers are packed as typed arrays.
+// The same value encoding is what the engine stores recorded data in (see VizValueWriter).
+struct VizByteWriter
+{
+    enum Tag : uint8_t
+    {
+        Null,
+        False,
+        True,
+        Int,
+        Double,
+        String,
+        Array,
+        Object,
+        IntArray,
+        DoubleArray,
+        UInt,  // Integers above the int64 range
+        Matrix, // varint rows, varint cols, then the cells in row-major order as one array value
+        Map     // the keys as one array value, then the values as another (same length)
+    };
+
+    string &out;
+
+    void byte(uint8_t b) { out += static_cast<char>(b); }
+
+    void varint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            byte(static_cast<uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        byte(static_cast<uint8_t>(v));
+    }
+
+    void zigzag(int64_t v) { varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+
+    void f64(double v)
+    {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof bits);
+        for (int i = 0; i < 8; ++i)
+            byte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+
+    void str(string_view s)
+    {
+        varint(s.size());
+        out += s;
+    }
+};
+
+// --- The container inside a stack, queue or priority_queue ---
+// The adapters keep it in their protected member `c` (and a priority_queue its ordering in `comp`).
+// Going through a derived class is the standard-conforming way to reach them without a copy.
+template <typename Adapter>
+struct VizAdapterAccess : Adapter
+{
+    static typename Adapter::container_type &container(Adapter &a) { return a.*&VizAdapterAccess::c; }
+    static const typename Adapter::container_type &container(const Adapter &a) { return a.*&VizAdapterAccess::c; }
+    static auto &compare(Adapter &a) { return a.*&VizAdapterAccess::comp; }
+};
+
+// --- A row-major matrix in one contiguous buffer ---
+// The storage behind v_matrix: one allocation for the whole table instead of one per row.
+template <typename T>
+struct VizMatrix
+{
+    using value_type = T;
+
+    size_t rows = 0, cols = 0;
+    vector<T> cells; // rows * cols, row after row
+
+    VizMatrix() = default;
+    VizMatrix(size_t r, size_t c, const T &fill = T{}) : rows(r), cols(c), cells(r * c, fill) {}
+
+    // From nested rows (the input parser's form), which must all have the same length
+    explicit VizMatrix(const vector<vector<T>> &nested) : rows(nested.size()), cols(nested.empty() ? 0 : nested[0].size())
+    {
+        cells.reserve(rows * cols);
+        for (const auto &row : nested)
+        {
+            if (row.size() != cols)
+                throw runtime_error("Matrix rows must all have the same length.");
+            cells.insert(cells.end(), row.begin(), row.end());
+        }
+    }
+
+    size_t index(size_t r, size_t c) const { return r * cols + c; }
+    decltype(auto) operator()(size_t r, size_t c) { return cells[index(r, c)]; }
+    decltype(auto) operator()(size_t r, size_t c) const { return cells[index(r, c)]; }
+
+    // One row of the cells, so `dp.data[i][j]` and `dp.data.size()` read the raw table the way
+    // they did when it was a vector<vector<T>> (without recording anything, like any `.data`)
+    template <typename Cells>
+    struct RowView
+    {
+        Cells *cells;
+        size_t first, count;
+
+        decltype(auto) operator[](size_t c) const { return (*cells)[first + c]; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        auto begin() const { return cells->begin() + first; }
+        auto end() const { return cells->begin() + first + count; }
+    };
+    RowView<vector<T>> operator[](size_t r) { return {&cells, index(r, 0), cols}; }
+    RowView<const vector<T>> operator[](size_t r) const { return {&cells, index(r, 0), cols}; }
+    size_t size() const { return rows; }
+    bool empty() const { return rows == 0; }
+};
+
+template <typename T>
+constexpr bool is_viz_matrix = false;
+template <typename T>
+constexpr bool is_viz_matrix<VizMatrix<T>> = true;
+
+// map, multimap, unordered_map, unordered_multimap (and anything shaped like them)
+template <typename T>
+constexpr bool is_map_like = requires { typename T::key_type; typename T::mapped_type; };
+
+// --- Direct serializer: C++ values straight into the binary value encoding ---
+// Dispatched at compile time on the shape of T, so a container is written element by element
+// into the buffer without building any intermediate tree. The layout is the one the frontend
+// consumes (VizValueReader::to_json gives the exported text): containers are arrays, and
+// map-like containers are columnar, {"keys": [...], "values": [...]} in iteration order.
+// Arrays and columns of integers or floating point numbers are packed.
+// Stacks, queues and priority queues are written as the container they wrap, in its order:
+// bottom to top, front to back, and heap order. A VizMatrix is its shape plus its flat cells,
+// exported as {"rows", "cols", "cells"}.
+struct VizValueWriter : VizByteWriter
+{
+    // Integers whose every value fits a zigzag varint can be packed as an IntArray
+    template <typename T>
+    static constexpr bool packs_as_int = is_integral_v<T> && !is_same_v<T, bool> && (is_signed_v<T> || sizeof(T) < sizeof(int64_t));
+
+    template <typename T>
+    void write(const T &data)
+    {
+        // vector<bool> hands out proxy references, e.g. `vec.data[i]` of a v_vector<bool>
+        if constexpr (is_same_v<T, bool> || is_same_v<T, vector<bool>::reference>)
+        {
+            byte(data ? True : False);
+        }
+        else if constexpr (is_integral_v<T> && is_signed_v<T>)
+        {
+            byte(Int);
+            zigzag(data);
+        }
+        else if constexpr (is_integral_v<T>)
+        {
+            if (static_cast<uint64_t>(data) > static_cast<uint64_t>(numeric_limits<int64_t>::max()))
+            {
+                byte(UInt);
+                varint(data);
+            }
+            else
+            {
+                byte(Int);
+                zigzag(static_cast<int64_t>(data));
+            }
+        }
+        else if constexpr (is_floating_point_v<T>)
+        {
+            byte(Double);
+            f64(data);
+        }
+        else if constexpr (is_enum_v<T>)
+        {
+            write(static_cast<underlying_type_t<T>>(data));
+        }
+        else if constexpr (is_convertible_v<const T &, string_view>)
+        {
+            byte(String);
+            str(string_view(data));
+        }
+        else if constexpr (requires { typename T::container_type; } && !requires { data.begin(); })
+        {
+            write(VizAdapterAccess<T>::container(data));
+        }
+        else if constexpr (is_viz_matrix<T>)
+        {
+            byte(Matrix);
+            varint(data.rows);
+            varint(data.cols);
+            write(data.cells);
+        }
+        else if constexpr (is_map_like<T>)
+        {
+            byte(Map);
+            write_array(data, data.size(), [](const auto &entry) -> const auto & { return entry.first; });
+            write_array(data, data.size(), [](const auto &entry) -> const auto & { return entry.second; });
+        }
+        // Vector-like containers (vector, list, deque, set, multiset, array, ...)
+        else if constexpr (requires { data.begin(); data.end(); })
+        {
+            size_t count = 0;
+            if constexpr (requires { data.size(); })
+                count = data.size();
+            else
+                count = distance(data.begin(), data.end());
+            write_array(data, count, [](const auto &item) -> decltype(auto) { return item; });
+        }
+        else if constexpr (requires { data.first; data.second; })
+        {
+            byte(Array);
+            varint(2);
+            write(data.first);
+            write(data.second);
+        }
+        // Any size tuple
+        else if constexpr (requires { tuple_size<T>::value; })
+        {
+            byte(Array);
+            varint(tuple_size<T>::value);
+            apply([&](const auto &...elements) { (write(elements), ...); }, data);
+        }
+        else
+        {
+            byte(String);
+            str("unsupported_type");
+        }
+    }
+
+    // The `count` items of `data`, each passed through `project`, as one array value
+    template <typename Container, typename Project>
+    void write_array(const Container &data, size_t count, Project project)
+    {
+        using Item = remove_cvref_t<decltype(project(*data.begin()))>;
+        if constexpr (packs_as_int<Item>)
+        {
+            byte(IntArray);
+            varint(count);
+            for (const auto &item : data)
+                zigzag(project(item));
+        }
+        else if constexpr (is_floating_point_v<Item>)
+        {
+            byte(DoubleArray);
+            varint(count);
+            for (const auto &item : data)
+                f64(project(item));
+        }
+        else
+        {
+            byte(Array);
+            varint(count);
+            for (const auto &item : data)
+                write(project(item));
+        }
+    }
+};
+
+// --- Counting-only profiling ---
+// With viz.profiling set the engine keeps no frames and no object states: update_state,
+// record_op and touch only bump the counters of their object, and log_frame only counts the
+// frame it would have logged. For sequence containers (vector, list, deque, stack, queue,
+// priority_queue, matrix) the position of every op also lands in one of `bucket_count` buckets,
+// bucket k holding the ops on the k-th sixteenth of the container as it was at that moment.
+struct VizObjectProfile
+{
+    static constexpr size_t bucket_count = 16;
+
+    string type;
+    uint64_t reads = 0, writes = 0, compares = 0, inserts = 0, erases = 0;
+    bool sequence = false;
+    size_t max_size = 0; // The largest the container got
+    array<uint64_t, bucket_count> buckets{};
+};
+
+class VizProfile
+{
+public:
+    uint64_t frames = 0; // Frames the run would have logged, before any budget
+    string error;        // What ended the run early, if anything
+
+    void clear()
+    {
+        objects.clear();
+        last = nullptr;
+        frames = 0;
+        error.clear();
+    }
+
+    // A whole new value. The first one is the object being created, not an op on it.
+    template <typename T>
+    void update(const string &name, const string &type, const T &data)
+    {
+        bool created = false;
+        auto &object = find(name, type, created);
+        if (!created)
+            object.writes++;
+        track(object, data, -1);
+    }
+
+    template <typename T>
+    void record(const string &name, const string &type, const T &data, const VizOp &op, const VizHighlights &highlights)
+    {
+        bool created = false;
+        auto &object = find(name, type, created);
+        int64_t at = -1;
+        switch (op.kind)
+        {
+        case VizOpKind::PushBack:
+        case VizOpKind::PushFront:
+        case VizOpKind::InsertSorted:
+        case VizOpKind::InsertKey:
+            object.inserts++;
+            break;
+        case VizOpKind::PopBack:
+        case VizOpKind::PopFront:
+        case VizOpKind::EraseValue:
+        case VizOpKind::Clear:
+            object.erases++;
+            break;
+        case VizOpKind::SetAt:
+        case VizOpKind::SetKey:
+            object.writes++;
+            break;
+        }
+        if constexpr (is_sequence<T>)
+        {
+            size_t size = size_of(data);
+            if (op.kind == VizOpKind::PushBack)
+                at = static_cast<int64_t>(size) - 1;
+            else if (op.kind == VizOpKind::PopBack)
+                at = static_cast<int64_t>(size); // Where the removed element was
+            else if (op.kind == VizOpKind::PushFront || op.kind == VizOpKind::PopFront)
+                at = 0;
+            else if (op.kind == VizOpKind::SetAt)
+                at = static_cast<int64_t>(op.index);
+            else
+                at = position(data, highlights);
+        }
+        track(object, data, at);
+    }
+
+    // A read, write or compare that records no op, counted by the state of its first highlight
+    template <typename T>
+    void touch(const string &name, const string &type, const T &data, const VizHighlights &highlights)
+    {
+        bool created = false;
+        auto &object = find(name, type, created);
+        VizState state = highlights.empty() ? VizState::Read : highlights.begin()->state;
+        (state == VizState::Write ? object.writes : state == VizState::Compare ? object.compares : object.reads)++;
+        track(object, data, is_sequence<T> ? position(data, highlights) : -1);
+    }
+
+    // The report dump_profile returns
+    string report() const;
+
+private:
+    map<string, VizObjectProfile> objects;          // Nodes never move, so `last` stays valid
+    pair<const string, VizObjectProfile> *last = nullptr; // Most runs hit the same object many times in a row
+
+    template <typename T>
+    static constexpr bool is_sequence = is_viz_matrix<T> || (requires(const T &t) { t.size(); typename T::value_type; } && !requires { typename T::key_type; } && !is_same_v<T, string>);
+
+    template <typename T>
+    static size_t size_of(const T &data)
+    {
+        if constexpr (is_viz_matrix<T>)
+            return data.cells.size();
+        else
+            return data.size();
+    }
+
+    // The element an op was on, from its first highlight (-1 when that does not name an element)
+    template <typename T>
+    static int64_t position(const T &data, const VizHighlights &highlights)
+    {
+        if (highlights.empty())
+            return -1;
+        const auto &h = *highlights.begin();
+        if (h.kind == VizHighlight::Number || h.kind == VizHighlight::Range)
+            return h.at[0];
+        if constexpr (is_viz_matrix<T>)
+        {
+            if (h.kind == VizHighlight::Cell || h.kind == VizHighlight::Row || h.kind == VizHighlight::Region)
+                return static_cast<int64_t>(data.index(h.at[0], h.kind == VizHighlight::Row ? 0 : h.at[1]));
+        }
+        return -1;
+    }
+
+    VizObjectProfile &find(const string &name, const string &type, bool &created)
+    {
+        if (last == nullptr || last->first != name)
+        {
+            auto [it, inserted] = objects.try_emplace(name);
+            if (inserted)
+                it->second.type = type;
+            created = inserted;
+            last = &*it;
+        }
+        return last->second;
+    }
+
+    template <typename T>
+    static void track(VizObjectProfile &object, const T &data, int64_t at)
+    {
+        if constexpr (is_sequence<T>)
+        {
+            size_t size = size_of(data);
+            object.sequence = true;
+            object.max_size = max(object.max_size, size);
+            if (at >= 0)
+            {
+                size = max(size, static_cast<size_t>(at) + 1);
+                object.buckets[min(static_cast<size_t>(at) * VizObjectProfile::bucket_count / size, VizObjectProfile::bucket_count - 1)]++;
+            }
+        }
+    }
+};
 
 // --- The Core Engine: The Visualizer ---
 class VizEngine
 {
+    // Declared first, so it outlives every frame and snapshot allocated from it
+    VizRunArena arena;
+    VizMemoryStats memory; // Before anything holding a snapshot: snapshots report to it when freed
+
 public:
-    json history;
-    map<string, json> object_states;
+    vector<VizFrame> history;
+    pmr::map<string, VizSnapshotPtr> object_states{&arena}; // The latest version of every object
+    VizStringTable strings;                    // Every name, type, highlight and message of this run
+    vector<VizArg> message_args;               // The message arguments of every frame in `history`
+
+    HistoryMode history_mode = HistoryMode::Delta;
+    size_t keyframe_interval = 256;
+
+    // --- Frame budget ---
+    // Upper bound on the number of frames a run can produce (0 = unlimited). Up to half of the
+    // budget every frame is kept. After that, frames that change data (and plain messages) are
+    // still kept, but frames that only read or compare are sampled, with the sampling stride
+    // doubling every time the remaining room halves. Once the budget is full everything is
+    // dropped, except a final frame from finish() that shows the end state.
+    static constexpr size_t default_frame_budget = 20000;
+    size_t frame_budget = default_frame_budget;
+
+    // --- Counting-only profiling (see VizProfile) ---
+    // Cheap enough for inputs far too large to animate; dump_profile() returns the report.
+    bool profiling = false;
+    VizProfile profile;
+
+    // --- Frame groups (see VizFrameGroup) ---
+    // While a group is open no frame is logged; changes and highlights pile up on the objects
+    // and show in the frame the outermost group logs when it closes.
+    void begin_group()
+    {
+        if (group_depth++ == 0)
+            group_serial++;
+    }
+
+    // True when this closed the outermost group, whose frame is to be logged now
+    bool end_group()
+    {
+        if (group_depth == 0 || --group_depth > 0)
+            return false;
+        frame_request = FrameRequest::None;
+        return true;
+    }
+
+    // --- Recording levels ---
+    // Objects below VizLevel::Full are kept in `levels`; the check costs nothing while it is empty.
+    void set_level(const string &name, VizLevel level)
+    {
+        if (level == VizLevel::Full)
+            levels.erase(name);
+        else
+            levels[name] = level;
+    }
 
     // NEW: Reset method to clear the state for a new run
-    void reset() {
-        history.clear();
-        object_states.clear();
+    void reset();
+
+    // --- Logs a frame with the message `tmpl`, every "{}" in it replaced by the next argument ---
+    // Arguments can be integers, floating point numbers (written like to_string) or strings.
+    // Nothing is formatted here: the template is interned and the arguments are stored as they are,
+    // so a frame costs the same whether it is kept or dropped by the budget.
+    template <typename... Args>
+    void log_frame(string_view tmpl, const Args &...args)
+    {
+        if (group_depth > 0)
+        {
+            frame_request = FrameRequest::None;
+            return; // The group logs one frame for all of it when it closes
+        }
+        if (profiling)
+        {
+            profile.frames++;
+            return;
+        }
+        if (exchange(frame_request, FrameRequest::None) == FrameRequest::Quiet)
+            return; // Everything since the last frame happened to objects that make no frames of their own
+        if (frame_budget > 0 && !keep_frame())
+        {
+            // Pending updates stay dirty, so their changes show up in the next kept frame
+            dropped_frames++;
+            last_dropped_message = strings.intern(tmpl);
+            last_dropped_args.clear();
+            (last_dropped_args.push_back(make_arg(args)), ...);
+            return;
+        }
+        uint32_t first = static_cast<uint32_t>(message_args.size());
+        (message_args.push_back(make_arg(args)), ...);
+        push_frame(strings.intern(tmpl), first);
+    }
+
+    // End of the run: if the budget dropped the last frames, show the final state anyway.
+    void finish();
+
+    // --- Reconstruction: rebuild the complete object map as it was at frame `index` ---
+    // Starts from the closest keyframe at or before `index` and replays the deltas after it.
+    map<string, VizSnapshotPtr> objects_at(size_t index) const;
+
+    // The complete frame `index` as JSON, as it appears in dump_history
+    string frame_at(size_t index) const;
+
+    // --- Export: the full-frame JSON array the frontend consumes ---
+    // Frames are reconstructed one at a time and written straight into the output text,
+    // so the complete history never exists as a single json tree. Op versions are replayed
+    // on top of the previously exported state of the same object.
+    string dump_history() const;
+
+    // The same, appended to `out`
+    void dump_history(string &out) const;
+
+    // --- Binary export: the same history in the compact "VCPB" format ---
+    // Layout: "VCPB" | version byte | varint new string count | strings | varint frame count | frames.
+    // Frame:  varint dropped | message template id | varint argument count | arguments | varint record count | records.
+    // Argument: kind byte (0 = zigzag int, 1 = varint unsigned, 2 = double, 3 = string id) | value.
+    // Record: name id | kind byte (0 = full data, 1 = edits) | type id | highlights | data value or edit list.
+    // Highlights are a varint count of (key id, state id) pairs. Ids index the string table, which
+    // every chunk extends with the strings added since the previous one.
+    string dump_history_binary() const;
+
+    // --- Memory accounting (see VizMemoryStats) ---
+    // What the history holds right now and the most it held during this run. Cheap enough to
+    // call after every frame, e.g. to stop logging before a run outgrows the Wasm memory.
+    VizMemoryStats stats() const;
+
+    // {"footprint": n, "peak": n, "peak_frame": n, "live": n, "snapshots": n, "frames": n, "strings": n,
+    //  "arena": n, "outside_arena": n, "objects": {name: {"live": n, "peak": n, "versions": n}}}
+    string dump_stats() const;
+
+    // --- Profiling report: operation counts per object, as JSON ---
+    // {"frames": n, "objects": {name: {type, reads, writes, compares, inserts, erases[, size, buckets]}}[, "error": what]}
+    string dump_profile() const;
+
+    // --- Streaming export ---
+    // Instead of keeping every frame until the end of the run, hand them to `sink` as soon as
+    // `frames_per_chunk` of them are ready. Every chunk is a complete JSON array of full frames
+    // (the same shape dump_history returns), or a binary chunk with its own header, and flushed
+    // frames are freed right away.
+    void stream_to(function<void(const string &)> sink, size_t frames_per_chunk, HistoryFormat format = HistoryFormat::Json);
+
+    // Every frame logged in this run, including the ones already streamed out
+    size_t frame_count() const { return flushed_frames + history.size(); }
+
+    // --- Serialization ---
+    // Values are written straight into the binary value encoding by VizValueWriter; nothing is
+    // turned into JSON text until the history is exported.
+    template <typename T>
+    static string encode_value(const T &data)
+    {
+        string out;
+        VizValueWriter{{out}}.write(data);
+        return out;
+    }
+
+    // One map entry, as the [key, value] pair ops carry (it lands in both columns on export)
+    template <typename Container>
+    static string encode_entry(const typename Container::value_type &entry)
+    {
+        return encode_value(entry);
     }
 
-    void log_frame(const string &message) { history.push_back({{"message", message}, {"objects", object_states}}); }
+    template <typename T>
+    static void serialize_data(const T &data, string &out)
+    {
+        VizValueWriter{{out}}.write(data);
+    }
 
-    // --- NEW: Universal JSON serialization helper using C++17 Fold Expressions ---
-    // Helper to apply a function to each element of a tuple
-    template <typename Tuple, typename Func, size_t... Is>
-    void for_each_in_tuple(Tuple &&tuple, Func &&func, index_sequence<Is...>)
+    // --- Dirty tracking ---
+    // update_state only remembers that the object changed and which highlights it wants.
+    // The object is serialized once, when the next frame is logged (or when it is destroyed).
+    template <typename T>
+    void update_state(const string &name, const string &type, const T &data, const VizHighlights &highlights = {})
     {
-        (func(get<Is>(tuple)), ...);
+        if (profiling)
+            return profile.update(name, type, data);
+        auto &pending = mark_dirty(name, type, data, audible(name, Change::Structure) ? &highlights : nullptr);
+        pending.full = true;
+        pending.ops.clear();
     }
 
+    // --- Operation records ---
+    // A wrapper that knows exactly what it changed records that op instead of asking for a full
+    // re-serialization. The first version of an object and any version after a full update_state
+    // in the same frame are still serialized in full. So is every version of an unordered
+    // container: an insert can rehash and reorder all of it, which no replayed op reproduces.
     template <typename T>
-    json to_json_recursive(const T &data)
+    void record_op(const string &name, const string &type, const T &data, VizOp op, const VizHighlights &highlights = {})
     {
-        // Base case: for simple scalar types like int, double, char, string, bool
-        if constexpr (is_scalar<T>::value || is_same_v<T, string>)
+        if (profiling)
+            return profile.record(name, type, data, op, highlights);
+        bool element = op.kind == VizOpKind::SetAt || op.kind == VizOpKind::SetKey;
+        auto &pending = mark_dirty(name, type, data, audible(name, element ? Change::Write : Change::Structure) ? &highlights : nullptr);
+        if constexpr (requires { typename T::hasher; })
         {
-            return data;
+            pending.full = true;
+            pending.ops.clear();
         }
-        // For vector-like containers (vector, list, deque, set, multiset, etc.)
-        else if constexpr (requires { data.begin(); data.end(); } && !is_same_v<T, map<int, int>> && !is_same_v<T, unordered_map<int, int>>)
+        else if (!pending.full)
         {
-            json j_arr = json::array();
-            for (const auto &item : data)
+            pending.ops.push_back(std::move(op));
+            if (pending.ops.size() >= pending.delta_limit)
             {
-                j_arr.push_back(to_json_recursive(item));
+                // Many ops piled up while frames were being dropped: a full version is cheaper
+                pending.full = true;
+                pending.ops.clear();
             }
-            return j_arr;
         }
-        // For map-like containers
-        else if constexpr (requires { data.begin()->first; data.begin()->second; })
+    }
+
+    // A read, compare or find: only the highlights change, the data stays as it is.
+    template <typename T>
+    void touch(const string &name, const string &type, const T &data, const VizHighlights &highlights = {})
+    {
+        if (profiling)
+            return profile.touch(name, type, data, highlights);
+        bool write = !highlights.empty() && highlights.begin()->state == VizState::Write;
+        if (audible(name, write ? Change::Write : Change::Read))
+            mark_dirty(name, type, data, &highlights); // Otherwise there is nothing to show: the data did not change
+    }
+
+    // Called by a wrapper that is going away: serialize its pending update while its data still exists.
+    void release(const void *source);
+
+private:
+    struct PendingUpdate
+    {
+        string type;
+        const void *source = nullptr; // The wrapper's data, used to match it up in release()
+        VizHighlights highlights; // Text keys already interned
+        vector<VizHighlight> group_highlights; // Inside a frame group: everything it highlighted, oldest first
+        uint64_t group = 0;                    // The group they were collected in
+        function<void(string &)> serialize; // Appends the object's serialized data
+        bool full = false;  // Serialize the whole object on commit
+        vector<VizOp> ops;  // Otherwise, the ops applied since the last committed version
+        size_t delta_limit = 0;
+    };
+
+    // How many op versions (or pending ops) may pile up on top of a full version before a new
+    // full one is made. At least keyframe_interval; for a large object, as many as take about
+    // the memory of one full copy, so a 2000x2000 table is not re-serialized every 256 writes.
+    size_t delta_limit(const VizSnapshot *current) const
+    {
+        return max(keyframe_interval, current ? current->full_size / sizeof(VizOp) : 0);
+    }
+
+    // The exported state of one object while replaying the history
+    // Op replays work on the elements of the data one by one, so the data is split into them
+    // the first time an op is applied. The JSON text is kept until the object changes again.
+    struct MaterializedObject
+    {
+        const VizSnapshot *applied = nullptr;
+        string data;          // Serialized data, while not split
+        string shape;         // A matrix's shape in front of its cells, once split
+        vector<string> items; // Serialized elements (a matrix's flat cells, a map's entries), once split
+        bool split = false;
+        bool entries = false; // The items are map entries, to be joined back into columns
+        string text; // JSON text of the current data, empty when not made yet
+
+        void split_items();
+
+        void encode(string &out) const;
+
+        const string &json_text();
+    };
+
+    // Turns frames into the exported JSON text, one after the other. It remembers the objects
+    // of the previous frame and their materialized data, so deltas and ops can be applied on top.
+    struct HistoryWriter
+    {
+        const VizEngine *engine;
+        map<string, VizSnapshotPtr> objects;
+        map<string, MaterializedObject> materialized;
+
+        explicit HistoryWriter(const VizEngine &owner) : engine(&owner) {}
+
+        void write(const VizFrame &frame, string &out);
+    };
+
+    // The binary counterpart of HistoryWriter. Objects whose version did not change since the
+    // last frame it wrote are left out, and op versions are sent as the edits they made.
+    struct BinaryHistoryWriter
+    {
+        const VizEngine *engine;
+        size_t sent_strings = 0; // Strings already sent in an earlier chunk
+        map<uint32_t, MaterializedObject> materialized;
+
+        explicit BinaryHistoryWriter(const VizEngine &owner) : engine(&owner) {}
+
+        void write_header(size_t frame_count, string &out);
+
+        void write(const VizFrame &frame, string &out);
+    };
+
+    function<void(const string &)> chunk_sink;
+    size_t chunk_frames = 0;
+    HistoryFormat chunk_format = HistoryFormat::Json;
+    size_t flushed_frames = 0;
+    HistoryWriter stream_writer{*this};
+    BinaryHistoryWriter stream_binary_writer{*this};
+
+    map<string, PendingUpdate> dirty_objects; // Objects marked by update_state, not serialized yet
+    set<string> changed_objects;               // Objects committed since the last logged frame
+    string scratch;                            // Reused serialization buffer
+
+    map<string, VizLevel> levels; // Objects recorded below VizLevel::Full
+    size_t group_depth = 0;       // Frame groups open right now
+    uint64_t group_serial = 0;    // Bumped every time an outermost group opens
+
+    // What the wrapper calls since the last frame asked for: nothing yet, only quiet changes, or a frame
+    enum class FrameRequest : uint8_t
+    {
+        None,
+        Quiet,
+        Audible
+    };
+    FrameRequest frame_request = FrameRequest::None;
+
+    // In the order of VizLevel: a change is audible at every level up to its own
+    enum class Change : uint8_t
+    {
+        Read,
+        Write,
+        Structure
+    };
+
+    bool audible(const string &name, Change change)
+    {
+        bool loud = true;
+        if (!levels.empty())
+        {
+            auto it = levels.find(name);
+            loud = it == levels.end() || static_cast<uint8_t>(change) >= static_cast<uint8_t>(it->second);
+        }
+        if (loud)
+            frame_request = FrameRequest::Audible;
+        else if (frame_request == FrameRequest::None)
+            frame_request = FrameRequest::Quiet;
+        return loud;
+    }
+
+    // `highlights` is null for a quiet change, which leaves the highlights already pending alone
+    template <typename T>
+    PendingUpdate &mark_dirty(const string &name, const string &type, const T &data, const VizHighlights *highlights)
+    {
+        auto [it, inserted] = dirty_objects.try_emplace(name);
+        auto &pending = it->second;
+        if (inserted)
         {
-            json j_map = json::array();
-            for (const auto &pair : data)
+            // Nothing to apply ops to yet: the first version of an object is always full
+            auto current = object_states.find(name);
+            pending.full = current == object_states.end();
+            pending.delta_limit = delta_limit(pending.full ? nullptr : current->second.get());
+        }
+        pending.type = type;
+        pending.source = &data;
+        if (highlights && group_depth > 0)
+        {
+            // The group's frame shows everything highlighted since it opened
+            if (pending.group != group_serial)
+            {
+                pending.group = group_serial;
+                pending.highlights = {};
+                pending.group_highlights.clear();
+            }
+            for (VizHighlight h : *highlights)
             {
-                j_map.push_back({{"key", to_json_recursive(pair.first)}, {"value", to_json_recursive(pair.second)}});
+                intern_text(h);
+                const auto *back = pending.group_highlights.empty() ? nullptr : &pending.group_highlights.back();
+                if (!back || back->kind != h.kind || back->state != h.state || back->real != h.real || !equal(begin(h.at), end(h.at), begin(back->at)))
+                    pending.group_highlights.push_back(h); // Repeats of the last one add nothing
             }
-            return j_map;
         }
-        // For pair
-        else if constexpr (requires { data.first; data.second; })
+        else if (highlights)
         {
-            return {to_json_recursive(data.first), to_json_recursive(data.second)};
+            pending.highlights = *highlights;
+            pending.group_highlights.clear();
+            for (auto &h : pending.highlights)
+                intern_text(h);
         }
-        // THE UPGRADE: For ANY size tuple
-        else if constexpr (requires { tuple_size<T>::value; })
+        pending.serialize = [&data](string &out) { serialize_data(data, out); };
+        return pending;
+    }
+
+    void intern_text(VizHighlight &h)
+    {
+        if (h.kind == VizHighlight::Text)
         {
-            json j_arr = json::array();
-            for_each_in_tuple(data, [&](const auto &element)
-                              { j_arr.push_back(to_json_recursive(element)); }, make_index_sequence<tuple_size<T>::value>{});
-            return j_arr;
+            h.at[0] = strings.intern(h.text); // The text may not outlive the call that recorded it
+            h.text = {};
         }
-        // Fallback for unknown types
-        return "unsupported_type";
     }
 
+    // Copy-on-write: older frames keep pointing at the previous version untouched
+    void commit(const string &name, PendingUpdate &pending);
+
+    void commit_dirty();
+
+    // Bring `object` up to `target`, replaying op versions from the closest state we already have.
+    // Returns true when the data had to be replaced by a full version; otherwise every change
+    // made on the way is appended to `edits` (when given).
+    static bool materialize(MaterializedObject &object, const VizSnapshot *target, vector<VizEdit> *edits = nullptr);
+
+    size_t dropped_frames = 0; // Dropped since the last kept frame
+    size_t sampled_frames = 0; // Read / compare frames seen while sampling
+    uint32_t last_dropped_message = 0; // Template and arguments of the last dropped frame
+    vector<VizArg> last_dropped_args;
+
+    // A frame that changes data, or that only carries a message, is structural.
+    // A frame whose pending updates only move highlights around is a read / compare frame.
+    bool is_structural_frame() const;
+
+    bool keep_frame();
+
     template <typename T>
-    void update_state(const string &name, const string &type, const T &data, const map<string, string> &highlights = {})
+    VizArg make_arg(const T &value)
     {
-        json j_data;
-
-        // THE UPGRADE: Templatized Stack/Queue/PQ serialization
-        if constexpr (requires { T().top(); T().pop(); })
-        { // Stack or PQ
-            T temp = data;
-            vector<json> temp_vec;
-            while (!temp.empty())
-            {
-                temp_vec.push_back(to_json_recursive(temp.top()));
-                temp.pop();
-            }
-            j_data = temp_vec;
+        VizArg arg;
+        if constexpr (viz_is_char<T>)
+        {
+            char c = static_cast<char>(value);
+            arg.kind = VizArg::String;
+            arg.s = strings.intern(string_view(&c, 1));
         }
-        else if constexpr (requires { T().front(); T().pop(); })
-        { // Queue
-            T temp = data;
-            vector<json> temp_vec;
-            while (!temp.empty())
-            {
-                temp_vec.push_back(to_json_recursive(temp.front()));
-                temp.pop();
-            }
-            j_data = temp_vec;
+        else if constexpr (is_integral_v<T> && is_signed_v<T>)
+        {
+            arg.kind = VizArg::Int;
+            arg.i = value;
+        }
+        else if constexpr (is_integral_v<T>)
+        {
+            arg.kind = VizArg::Unsigned;
+            arg.u = value;
+        }
+        else if constexpr (is_floating_point_v<T>)
+        {
+            arg.kind = VizArg::Double;
+            arg.d = value;
         }
         else
         {
-            // The update function is now incredibly simple for everything else!
-            j_data = to_json_recursive(data);
+            arg.kind = VizArg::String;
+            arg.s = strings.intern(string_view(value));
         }
-
-        object_states[name] = {{"type", type}, {"data", j_data}, {"highlights", highlights}};
+        return arg;
     }
+
+    // The text of a frame's message: every "{}" in the template replaced by the next argument,
+    // formatted the way to_string would. "{}" past the last argument is left as it is.
+    string message_text(const VizFrame &frame) const;
+
+    void push_frame(uint32_t message, uint32_t first_arg);
+
+    size_t frame_object_bytes = 0; // The object lists of the frames in `history`
+
+    size_t frame_bytes() const;
+
+    size_t outside_arena_bytes() const;
+
+    // Moves the high-water mark after the history grew
+    void note_memory();
+
+    void flush_chunk();
+
+    // Replays one op on the elements of an object, resolving where it lands
+    static void apply_op(vector<string> &data, const VizOp &op, vector<VizEdit> *edits = nullptr);
+
+    static void apply_frame(map<string, VizSnapshotPtr> &objects, const VizFrame &frame, const VizStringTable &strings);
 };
+#ifdef V_CPP_PREBUILT
+extern VizEngine viz; // Defined in v-cpp.cpp
+#else
 inline VizEngine viz;
+#endif
+
+// --- Frame groups ---
+// Folds everything a scope does into a single frame:
+//
+//     {
+//         VizFrameGroup group("Pruned the back of the deque");
+//         while (!dq.empty())
+//         {
+//             int back = arr[dq.data.back()];
+//             if (back >= current)
+//                 break;
+//             dq.pop_back();
+//         }
+//     } // <- one frame here, instead of one per read and per pop
+//
+// Inside the scope the wrappers log no frames. When the group goes out of scope, normally or
+// because of an exception, it logs one frame with its message in which every object shows what
+// the scope highlighted on it (a key read and then written shows as written). Groups nest: only
+// the outermost one logs its frame.
+class VizFrameGroup
+{
+public:
+    template <typename... Args>
+    explicit VizFrameGroup(string_view tmpl, const Args &...args)
+    {
+        message(tmpl, args...);
+        V_RECORD(viz.begin_group());
+    }
+
+    VizFrameGroup(const VizFrameGroup &) = delete;
+    VizFrameGroup &operator=(const VizFrameGroup &) = delete;
+
+    // Replaces the message, e.g. once the scope knows how much it did. Takes the same
+    // template and arguments as viz.log_frame. Numbers are kept as they are and anything else is
+    // copied into a string, so a `const char *` or string_view argument may die before the group.
+    template <typename... Args>
+    void message(string_view tmpl, const Args &...args)
+    {
+        V_RECORD(log = [tmpl = string(tmpl), ... owned = owned_arg(args)] { viz.log_frame(tmpl, owned...); });
+    }
+
+    // This may run while an exception unwinds the scope, where letting another one out would
+    // terminate the program: a frame that cannot be logged (e.g. out of memory) is left out instead.
+    ~VizFrameGroup()
+    {
+        V_RECORD(if (viz.end_group()) {
+            try
+            {
+                log();
+            }
+            catch (...)
+            {
+            }
+        });
+    }
+
+private:
+    function<void()> log;
+
+    template <typename T>
+    static auto owned_arg(const T &value)
+    {
+        if constexpr (is_arithmetic_v<T>)
+            return value;
+        else
+            return string(string_view(value));
+    }
+};
 
 // Base class for all visualizable objects
+// Every wrapper declares `~v_xxx() { V_RECORD(viz.release(&data)); }` so a still-pending update is
+// serialized before its data is destroyed.
 class v_base
 {
 public:
@@ -156,12 +1523,8 @@ public:
     template <typename T = typename Parent::DataType::value_type>
     operator T() const
     {
-        // Use stringstream for a universal, non-ambiguous to-string conversion.
-        stringstream ss;
-        ss << key;
-        string h_key = ss.str(); // Simplified for visualization key
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{h_key, "read"}});
-        viz.log_frame("Reading from " + parent->v_name + " at key/index " + h_key);
+        V_RECORD(viz.touch(parent->v_name, parent->v_type, parent->data, {{key, VizState::Read}}));
+        V_RECORD(viz.log_frame("Reading from {} at key/index {}", parent->v_name, key));
 
         if constexpr (requires { typename Parent::DataType::key_type; })
         { // Map-like
@@ -178,12 +1541,18 @@ public:
     v_proxy &operator=(const T &value)
     {
         parent->data[key] = value;
-        stringstream ss;
-        ss << key;
-        string h_key = ss.str(); // Simplified for visualization key
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{h_key, "write"}});
+        if constexpr (requires { typename Parent::DataType::key_type; })
+        { // Map-like: replace (or insert) the whole entry
+            V_RECORD(viz.record_op(parent->v_name, parent->v_type, parent->data,
+                                   {VizOpKind::SetKey, 0, viz.encode_value(key), viz.encode_entry<typename Parent::DataType>(*parent->data.find(key))}, {{key, VizState::Write}}));
+        }
+        else
+        { // Vector-like
+            V_RECORD(viz.record_op(parent->v_name, parent->v_type, parent->data,
+                                   {VizOpKind::SetAt, static_cast<size_t>(key), {}, viz.encode_value(parent->data[key])}, {{key, VizState::Write}}));
+        }
         // We can't easily stringify generic types here, so we keep the message simple.
-        viz.log_frame("Writing to " + parent->v_name + " at key/index " + h_key);
+        V_RECORD(viz.log_frame("Writing to {} at key/index {}", parent->v_name, key));
         return *this;
     }
 };
@@ -207,18 +1576,19 @@ public:
     v_proxy_2d_row &operator=(const std::vector<T> &new_row_values)
     {
         // Step 1: Replace the data in the specified row of the parent matrix.
-        parent->data[row] = new_row_values;
+        auto &data = parent->data;
+        if (new_row_values.size() != data.cols)
+            throw runtime_error("Row " + to_string(row) + " of '" + parent->v_name + "' has " + to_string(data.cols) + " columns, got " + to_string(new_row_values.size()) + " values.");
 
-        // Step 2: Update the visual state. We will highlight every cell in the changed row.
-        map<string, string> highlights;
-        for (size_t col = 0; col < new_row_values.size(); ++col)
+        // Step 2: Update the visual state. One row highlight instead of one entry per cell.
+        for (size_t col = 0; col < data.cols; ++col)
         {
-            highlights[to_string(row) + "-" + to_string(col)] = "write";
+            data(row, col) = new_row_values[col];
+            V_RECORD(viz.record_op(parent->v_name, parent->v_type, data, {VizOpKind::SetAt, data.index(row, col), {}, viz.encode_value(data(row, col))}, {VizHighlight::row(row, VizState::Write)}));
         }
-        viz.update_state(parent->v_name, parent->v_type, parent->data, highlights);
 
         // Step 3: Log a single, clean frame for this action.
-        viz.log_frame("Assigned new values to row " + to_string(row) + " of '" + parent->v_name + "'.");
+        V_RECORD(viz.log_frame("Assigned new values to row {} of '{}'.", row, parent->v_name));
 
         // Step 4: Return a reference to this proxy object.
         return *this;
@@ -236,23 +1606,23 @@ public:
     v_proxy_2d_cell(Parent *p, int r, int c) : parent(p), row(r), col(c) {}
 
     // Universal Read Operator for Matrix Cell
-    template <typename T = typename Parent::DataType::value_type::value_type>
+    template <typename T = typename Parent::DataType::value_type>
     operator T() const
     {
-        string h_key = to_string(row) + "-" + to_string(col);
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{h_key, "read"}});
-        viz.log_frame("Read from " + parent->v_name + "[" + to_string(row) + "][" + to_string(col) + "]");
-        return parent->data[row][col];
+        V_RECORD(viz.touch(parent->v_name, parent->v_type, parent->data, {VizHighlight::cell(row, col, VizState::Read)}));
+        V_RECORD(viz.log_frame("Read from {}[{}][{}]", parent->v_name, row, col));
+        return parent->data(row, col);
     }
 
     // Universal Write Operator for Matrix Cell
     template <typename T>
     v_proxy_2d_cell &operator=(const T &value)
     {
-        parent->data[row][col] = value;
-        string h_key = to_string(row) + "-" + to_string(col);
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{h_key, "write"}});
-        viz.log_frame("Write to " + parent->v_name + "[" + to_string(row) + "][" + to_string(col) + "]");
+        auto &data = parent->data;
+        data(row, col) = value;
+        V_RECORD(viz.record_op(parent->v_name, parent->v_type, data,
+                               {VizOpKind::SetAt, data.index(row, col), {}, viz.encode_value(data(row, col))}, {VizHighlight::cell(row, col, VizState::Write)}));
+        V_RECORD(viz.log_frame("Write to {}[{}][{}]", parent->v_name, row, col));
         return *this;
     }
 };
@@ -270,8 +1640,8 @@ public:
     // Reading from the element (e.g., int x = v_get<0>(my_pair);)
     operator auto() const
     {
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{to_string(Index), "read"}});
-        viz.log_frame("Reading element " + to_string(Index) + " from '" + parent->v_name + "'.");
+        V_RECORD(viz.touch(parent->v_name, parent->v_type, parent->data, {{Index, VizState::Read}}));
+        V_RECORD(viz.log_frame("Reading element {} from '{}'.", Index, parent->v_name));
         return get<Index>(parent->data);
     }
 
@@ -280,8 +1650,9 @@ public:
     v_get_proxy &operator=(const T &value)
     {
         get<Index>(parent->data) = value;
-        viz.update_state(parent->v_name, parent->v_type, parent->data, {{to_string(Index), "write"}});
-        viz.log_frame("Writing to element " + to_string(Index) + " of '" + parent->v_name + "'.");
+        V_RECORD(viz.record_op(parent->v_name, parent->v_type, parent->data,
+                               {VizOpKind::SetAt, Index, {}, viz.encode_value(get<Index>(parent->data))}, {{Index, VizState::Write}}));
+        V_RECORD(viz.log_frame("Writing to element {} of '{}'.", Index, parent->v_name));
         return *this;
     }
 };
@@ -293,18 +1664,19 @@ class v_pair : public v_base
 public:
     using DataType = pair<T1, T2>;
     pair<T1, T2> data;
+    ~v_pair() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create a default-initialized pair ---
     v_pair(string n) : v_base(n, "pair"), data()
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created default-initialized pair '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created default-initialized pair '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ pair ---
     v_pair(string n, const std::pair<T1, T2> &iv) : v_base(n, "pair"), data(iv)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created pair '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created pair '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::pair ---
@@ -312,8 +1684,8 @@ public:
     {
         this->data = new_values;
         // Highlight both elements of the pair on write
-        viz.update_state(v_name, v_type, this->data, {{"0", "write"}, {"1", "write"}});
-        viz.log_frame("Assigned new contents to pair '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data, {{0, VizState::Write}, {1, VizState::Write}}));
+        V_RECORD(viz.log_frame("Assigned new contents to pair '{}'.", v_name));
         return *this;
     }
 };
@@ -325,19 +1697,20 @@ class v_tuple : public v_base
 public:
     using DataType = tuple<Types...>;
     DataType data;
+    ~v_tuple() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create a default-initialized tuple ---
     v_tuple(string n) : v_base(n, "tuple"), data()
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created default-initialized tuple '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created default-initialized tuple '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ tuple ---
     v_tuple(string n, const DataType &iv) : v_base(n, "tuple"), data(iv)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created tuple '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created tuple '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::tuple ---
@@ -346,14 +1719,8 @@ public:
         this->data = new_values;
 
         // Highlight all elements of the tuple on write
-        map<string, string> highlights;
-        [&]<size_t... Is>(index_sequence<Is...>)
-        {
-            ((highlights[to_string(Is)] = "write"), ...);
-        }(index_sequence_for<Types...>{});
-
-        viz.update_state(v_name, v_type, this->data, highlights);
-        viz.log_frame("Assigned new contents to tuple '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data, {VizHighlight::range(0, sizeof...(Types) - 1, VizState::Write)}));
+        V_RECORD(viz.log_frame("Assigned new contents to tuple '{}'.", v_name));
         return *this;
     }
 };
@@ -380,65 +1747,60 @@ class v_scalar : public v_base
 public:
     using DataType = T;
     T data;
+    ~v_scalar() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1 (NEW): Create a default-initialized scalar ---
     v_scalar(string n) : v_base(n, is_same_v<T, string> ? "string" : (is_same_v<T, bool> ? "bool" : "scalar")),
                          data() // Default-initializes the data (0 for int, false for bool, "" for string, etc.)
     {
-        viz.update_state(v_name, v_type, data);
+        V_RECORD(viz.update_state(v_name, v_type, data));
 
-        string value_str;
         if constexpr (is_same_v<T, string>)
         {
-            value_str = "\"" + data + "\""; // Put quotes around empty string
+            V_RECORD(viz.log_frame("Created default-initialized {} '{}' with value \"{}\"", v_type, v_name, data)); // Quote strings for clarity
         }
         else
         {
-            value_str = std::to_string(data);
+            V_RECORD(viz.log_frame("Created default-initialized {} '{}' with value {}", v_type, v_name, data));
         }
-        viz.log_frame("Created default-initialized " + v_type + " '" + v_name + "' with value " + value_str);
     }
 
     // --- Constructor 2: Create with an initial value ---
     v_scalar(string n, T iv) : v_base(n, is_same_v<T, string> ? "string" : (is_same_v<T, bool> ? "bool" : "scalar")),
                                data(iv)
     {
-        viz.update_state(v_name, v_type, data);
+        V_RECORD(viz.update_state(v_name, v_type, data));
 
-        string value_str;
         if constexpr (is_same_v<T, string>)
         {
-            value_str = "\"" + data + "\""; // Put quotes around the string for clarity
+            V_RECORD(viz.log_frame("Created {} '{}' with value \"{}\"", v_type, v_name, data));
         }
         else
         {
-            value_str = std::to_string(data);
+            V_RECORD(viz.log_frame("Created {} '{}' with value {}", v_type, v_name, data));
         }
-        viz.log_frame("Created " + v_type + " '" + v_name + "' with value " + value_str);
     }
 
     // --- The Assignment Operator ---
     v_scalar<T> &operator=(T v)
     {
         data = v;
-        viz.update_state(v_name, v_type, data, {{"0", "write"}});
+        V_RECORD(viz.update_state(v_name, v_type, data, {{0, VizState::Write}}));
 
-        string value_str;
         if constexpr (is_same_v<T, string>)
         {
-            value_str = "\"" + data + "\"";
+            V_RECORD(viz.log_frame("Set '{}' = \"{}\"", v_name, data));
         }
         else
         {
-            value_str = std::to_string(data);
+            V_RECORD(viz.log_frame("Set '{}' = {}", v_name, data));
         }
-        viz.log_frame("Set '" + v_name + "' = " + value_str);
 
         return *this;
     }
     operator T() const
     {
-        viz.update_state(v_name, v_type, data, {{"0", "read"}});
-        viz.log_frame("Read " + v_name);
+        V_RECORD(viz.touch(v_name, v_type, data, {{0, VizState::Read}}));
+        V_RECORD(viz.log_frame("Read {}", v_name));
         return data;
     }
 };
@@ -448,16 +1810,17 @@ class v_vector : public v_base
 public:
     using DataType = vector<T>;
     vector<T> data;
+    ~v_vector() { V_RECORD(viz.release(&data)); }
     v_vector(string n, int size) : v_base(n, "vector"), data(size)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created vector '" + v_name + "' with size " + to_string(size));
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created vector '{}' with size {}", v_name, size));
     }
     // --- Constructor 2: Initialize from an existing std::vector ---
     v_vector(string n, const std::vector<T> &initial_values) : v_base(n, "vector"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created vector '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created vector '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::vector ---
@@ -468,10 +1831,10 @@ public:
 
         // Step 2: Update the visual state to show the new data.
         // We will highlight the entire vector to show it was changed.
-        viz.update_state(v_name, v_type, this->data, {{"0", "write"}}); // Note: highlighting '0' is a simple way to pulse the object.
+        V_RECORD(viz.update_state(v_name, v_type, this->data, {{0, VizState::Write}})); // Note: highlighting '0' is a simple way to pulse the object.
 
         // Step 3: Log a frame to capture this change.
-        viz.log_frame("Assigned new contents to vector '" + v_name + "'.");
+        V_RECORD(viz.log_frame("Assigned new contents to vector '{}'.", v_name));
 
         // Step 4: Return a reference to this object, as is standard for operator=.
         return *this;
@@ -483,17 +1846,8 @@ public:
     void push_back(T v)
     {
         data.push_back(v);
-        viz.update_state(v_name, v_type, data, {{to_string(data.size() - 1), "write"}});
-        string value_str;
-        if constexpr (is_same_v<T, string>)
-        {
-            value_str = v;
-        }
-        else
-        {
-            value_str = std::to_string(v);
-        }
-        viz.log_frame("Pushed " + value_str + " to '" + v_name + "'");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{data.size() - 1, VizState::Write}}));
+        V_RECORD(viz.log_frame("Pushed {} to '{}'", v, v_name));
     }
     size_t size() const { return data.size(); }
 };
@@ -503,34 +1857,35 @@ class v_list : public v_base
 public:
     using DataType = list<T>;
     list<T> data;
+    ~v_list() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create an empty list ---
     v_list(string n) : v_base(n, "list")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty list '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty list '{}'.", v_name));
     }
 
     // --- Constructor 2: Create a list of a specific size (with default values) ---
     v_list(string n, int size) : v_base(n, "list"), data(size)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created list '" + v_name + "' with size " + to_string(size));
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created list '{}' with size {}", v_name, size));
     }
 
     // --- Constructor 3: Create from a standard C++ list ---
     v_list(string n, const std::list<T> &initial_values) : v_base(n, "list"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created list '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created list '{}' from initial data.", v_name));
     }
 
     // --- Assignment Operator from a std::list ---
     v_list<T> &operator=(const std::list<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to list '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to list '{}'.", v_name));
         return *this;
     }
 
@@ -538,8 +1893,8 @@ public:
     void push_back(const T &v)
     {
         data.push_back(v);
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Pushed back " + to_string(v) + " to '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}));
+        V_RECORD(viz.log_frame("Pushed back {} to '{}'.", v, v_name));
     }
 
     void pop_back()
@@ -547,15 +1902,15 @@ public:
         if (data.empty())
             return;
         data.pop_back();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped back from '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopBack}));
+        V_RECORD(viz.log_frame("Popped back from '{}'.", v_name));
     }
 
     void push_front(const T &v)
     {
         data.push_front(v);
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Pushed front " + to_string(v) + " to '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushFront, 0, {}, viz.encode_value(v)}));
+        V_RECORD(viz.log_frame("Pushed front {} to '{}'.", v, v_name));
     }
 
     void pop_front()
@@ -563,15 +1918,15 @@ public:
         if (data.empty())
             return;
         data.pop_front();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped front from '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopFront}));
+        V_RECORD(viz.log_frame("Popped front from '{}'.", v_name));
     }
 
     void clear()
     {
         data.clear();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Cleared list '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::Clear}));
+        V_RECORD(viz.log_frame("Cleared list '{}'.", v_name));
     }
 
     // --- Utility Functions ---
@@ -585,12 +1940,13 @@ public:
     // The internal data type is now a standard stack
     using DataType = std::stack<T>;
     DataType data;
+    ~v_stack() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create an empty stack ---
     v_stack(string n) : v_base(n, "stack")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty stack '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty stack '{}'.", v_name));
     }
 
     // --- Constructor 2 (THE NEW GENERIC ONE): Create from ANY compatible container ---
@@ -598,8 +1954,8 @@ public:
     v_stack(string n, const Container &initial_values) : v_base(n, "stack"),
                                                          data(initial_values) // std::stack's constructor can take a container like vector or deque
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created stack '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created stack '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a compatible container ---
@@ -611,8 +1967,8 @@ public:
         this->data = DataType(new_values);
 
         // Step 2: Update the visual state and log the change.
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to stack '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to stack '{}'.", v_name));
 
         return *this;
     }
@@ -621,15 +1977,15 @@ public:
     void push(T v)
     {
         data.push(v);
-        viz.update_state(v_name, v_type, data, {{"top", "write"}});
-        viz.log_frame("Pushed " + to_string(v) + " onto stack '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{"top", VizState::Write}})); // Serialized bottom to top
+        V_RECORD(viz.log_frame("Pushed {} onto stack '{}'.", v, v_name));
     }
 
     T top()
     {
         T v = data.top();
-        viz.update_state(v_name, v_type, data, {{"top", "read"}});
-        viz.log_frame("Read top element (" + to_string(v) + ") from stack '" + v_name + "'.");
+        V_RECORD(viz.touch(v_name, v_type, data, {{"top", VizState::Read}}));
+        V_RECORD(viz.log_frame("Read top element ({}) from stack '{}'.", v, v_name));
         return v;
     }
 
@@ -639,8 +1995,8 @@ public:
             return;
         T v = data.top();
         data.pop();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped element (" + to_string(v) + ") from stack '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopBack}));
+        V_RECORD(viz.log_frame("Popped element ({}) from stack '{}'.", v, v_name));
     }
 
     bool empty() const { return data.empty(); }
@@ -651,12 +2007,13 @@ class v_queue : public v_base
 public:
     using DataType = std::queue<T>;
     DataType data;
+    ~v_queue() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create an empty queue ---
     v_queue(string n) : v_base(n, "queue")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty queue '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty queue '{}'.", v_name));
     }
 
     // --- Constructor 2 (THE NEW GENERIC ONE): Create from ANY compatible container ---
@@ -664,8 +2021,8 @@ public:
     v_queue(string n, const Container &initial_values) : v_base(n, "queue"),
                                                          data(initial_values) // std::queue's constructor also takes a container
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created queue '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created queue '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a compatible container ---
@@ -676,8 +2033,8 @@ public:
         this->data = DataType(new_values);
 
         // Step 2: Update the visual state and log the change.
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to queue '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to queue '{}'.", v_name));
 
         return *this;
     }
@@ -686,15 +2043,15 @@ public:
     void push(T v)
     {
         data.push(v);
-        viz.update_state(v_name, v_type, data, {{"back", "write"}});
-        viz.log_frame("Pushed " + to_string(v) + " to queue '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{"back", VizState::Write}}));
+        V_RECORD(viz.log_frame("Pushed {} to queue '{}'.", v, v_name));
     }
 
     T front()
     {
         T v = data.front();
-        viz.update_state(v_name, v_type, data, {{"front", "read"}});
-        viz.log_frame("Read front element (" + to_string(v) + ") from queue '" + v_name + "'.");
+        V_RECORD(viz.touch(v_name, v_type, data, {{"front", VizState::Read}}));
+        V_RECORD(viz.log_frame("Read front element ({}) from queue '{}'.", v, v_name));
         return v;
     }
 
@@ -704,8 +2061,8 @@ public:
             return;
         T v = data.front();
         data.pop();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped element (" + to_string(v) + ") from queue '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopFront}));
+        V_RECORD(viz.log_frame("Popped element ({}) from queue '{}'.", v, v_name));
     }
 
     bool empty() const
@@ -719,27 +2076,28 @@ class v_deque : public v_base
 public:
     using DataType = deque<T>;
     deque<T> data;
+    ~v_deque() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create an empty deque ---
     v_deque(string n) : v_base(n, "deque")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty deque '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty deque '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ deque ---
     v_deque(string n, const std::deque<T> &initial_values) : v_base(n, "deque"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created deque '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created deque '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::deque ---
     v_deque<T> &operator=(const std::deque<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to deque '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to deque '{}'.", v_name));
         return *this;
     }
 
@@ -751,15 +2109,15 @@ public:
     void push_back(T v)
     {
         data.push_back(v);
-        viz.update_state(v_name, v_type, data, {{"back", "write"}});
-        viz.log_frame("Pushed back " + to_string(v) + " to '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{"back", VizState::Write}}));
+        V_RECORD(viz.log_frame("Pushed back {} to '{}'.", v, v_name));
     }
 
     void push_front(T v)
     {
         data.push_front(v);
-        viz.update_state(v_name, v_type, data, {{"front", "write"}});
-        viz.log_frame("Pushed front " + to_string(v) + " to '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushFront, 0, {}, viz.encode_value(v)}, {{"front", VizState::Write}}));
+        V_RECORD(viz.log_frame("Pushed front {} to '{}'.", v, v_name));
     }
 
     void pop_back()
@@ -767,8 +2125,8 @@ public:
         if (data.empty())
             return;
         data.pop_back();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped back from '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopBack}));
+        V_RECORD(viz.log_frame("Popped back from '{}'.", v_name));
     }
 
     void pop_front()
@@ -776,8 +2134,8 @@ public:
         if (data.empty())
             return;
         data.pop_front();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped front from '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopFront}));
+        V_RECORD(viz.log_frame("Popped front from '{}'.", v_name));
     }
 };
 template <typename T>
@@ -786,12 +2144,13 @@ class v_priority_queue : public v_base
 public:
     using DataType = priority_queue<T, std::vector<T>, std::less<T>>;
     DataType data;
+    ~v_priority_queue() { V_RECORD(viz.release(&data)); }
 
     // --- Constructor 1: Create an empty priority_queue ---
     v_priority_queue(string n) : v_base(n, "priority_queue")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty priority_queue '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty priority_queue '{}'.", v_name));
     }
 
     // --- Constructor 2 (NEW GENERIC FEATURE): Create from ANY compatible container ---
@@ -800,8 +2159,8 @@ public:
                                                                   // The std::priority_queue constructor automatically performs the heapify operation
                                                                   data(initial_values.begin(), initial_values.end())
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created priority_queue '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created priority_queue '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a compatible container ---
@@ -813,25 +2172,40 @@ public:
         this->data = DataType(new_values.begin(), new_values.end());
 
         // Step 2: Update the visual state and log the change.
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to priority_queue '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to priority_queue '{}'.", v_name));
 
         return *this;
     }
 
     // --- Visualizable Member Functions ---
+    // push and pop do the heap work themselves on the underlying vector (the same sift-up /
+    // sift-down std::priority_queue does), so every slot that moves is recorded as an op.
     void push(T v)
     {
-        data.push(v);
-        viz.update_state(v_name, v_type, data, {{"top", "write"}});
-        viz.log_frame("Pushed " + to_string(v) + " to priority_queue '" + v_name + "'.");
+        auto &heap = VizAdapterAccess<DataType>::container(data);
+        auto &less = VizAdapterAccess<DataType>::compare(data);
+        heap.push_back(v);
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{"top", VizState::Write}}));
+        size_t i = heap.size() - 1;
+        while (i > 0 && less(heap[(i - 1) / 2], heap[i]))
+        {
+            swap(heap[(i - 1) / 2], heap[i]);
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::SetAt, i, {}, viz.encode_value(heap[i])}, {{"top", VizState::Write}}));
+            i = (i - 1) / 2;
+        }
+        if (i != heap.size() - 1)
+        {
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::SetAt, i, {}, viz.encode_value(heap[i])}, {{"top", VizState::Write}}));
+        }
+        V_RECORD(viz.log_frame("Pushed {} to priority_queue '{}'.", v, v_name));
     }
 
     T top()
     {
         T v = data.top();
-        viz.update_state(v_name, v_type, data, {{"top", "read"}});
-        viz.log_frame("Read top element (" + to_string(v) + ") from priority_queue '" + v_name + "'.");
+        V_RECORD(viz.touch(v_name, v_type, data, {{"top", VizState::Read}}));
+        V_RECORD(viz.log_frame("Read top element ({}) from priority_queue '{}'.", v, v_name));
         return v;
     }
 
@@ -840,9 +2214,30 @@ public:
         if (data.empty())
             return;
         T v = data.top();
-        data.pop();
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Popped element (" + to_string(v) + ") from priority_queue '" + v_name + "'.");
+        auto &heap = VizAdapterAccess<DataType>::container(data);
+        auto &less = VizAdapterAccess<DataType>::compare(data);
+        heap.front() = std::move(heap.back());
+        heap.pop_back();
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PopBack}));
+        if (!heap.empty())
+        {
+            size_t i = 0;
+            while (true)
+            {
+                size_t largest = i, left = 2 * i + 1, right = left + 1;
+                if (left < heap.size() && less(heap[largest], heap[left]))
+                    largest = left;
+                if (right < heap.size() && less(heap[largest], heap[right]))
+                    largest = right;
+                if (largest == i)
+                    break;
+                swap(heap[i], heap[largest]);
+                V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::SetAt, i, {}, viz.encode_value(heap[i])}));
+                i = largest;
+            }
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::SetAt, i, {}, viz.encode_value(heap[i])}));
+        }
+        V_RECORD(viz.log_frame("Popped element ({}) from priority_queue '{}'.", v, v_name));
     }
 
     bool empty() const { return data.empty(); }
@@ -854,44 +2249,49 @@ class v_set : public v_base
 public:
     using DataType = set<T>;
     set<T> data;
+    ~v_set() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty set ---
     v_set(string n) : v_base(n, "set")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty set '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty set '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ set ---
     v_set(string n, const std::set<T> &initial_values) : v_base(n, "set"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created set '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created set '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::set ---
     v_set<T> &operator=(const std::set<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data); // No specific highlight, just show the new state
-        viz.log_frame("Assigned new contents to set '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data)); // No specific highlight, just show the new state
+        V_RECORD(viz.log_frame("Assigned new contents to set '{}'.", v_name));
         return *this;
     }
     void insert(T v)
     {
-        data.insert(v);
-        viz.update_state(v_name, v_type, data, {{to_string(v), "write"}});
+        if (data.insert(v).second)
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::InsertSorted, 0, {}, viz.encode_value(v)}, {{v, VizState::Write}}));
+        else
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Write}}));
     }
     void erase(T v)
     {
-        data.erase(v);
-        viz.update_state(v_name, v_type, data, {{to_string(v), "read"}}); // Highlight the value being removed
-        viz.log_frame("Erased " + to_string(v) + " from " + v_name);
+        if (data.erase(v))
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::EraseValue, 0, {}, viz.encode_value(v)}, {{v, VizState::Read}})); // Highlight the value being removed
+        else
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Read}}));
+        V_RECORD(viz.log_frame("Erased {} from {}", v, v_name));
     }
     bool find(T v)
     {
         bool found = data.count(v) > 0;
-        viz.update_state(v_name, v_type, data, {{to_string(v), "compare"}});
-        viz.log_frame("Finding " + to_string(v) + " in " + v_name);
+        V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Compare}}));
+        V_RECORD(viz.log_frame("Finding {} in {}", v, v_name));
         return found;
     }
 };
@@ -901,26 +2301,27 @@ class v_multiset : public v_base
 public:
     using DataType = multiset<T>;
     multiset<T> data;
+    ~v_multiset() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty multiset ---
     v_multiset(string n) : v_base(n, "multiset")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty multiset '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty multiset '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ multiset ---
     v_multiset(string n, const std::multiset<T> &initial_values) : v_base(n, "multiset"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created multiset '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created multiset '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::multiset ---
     v_multiset<T> &operator=(const std::multiset<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to multiset '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to multiset '{}'.", v_name));
         return *this;
     }
 
@@ -928,18 +2329,18 @@ public:
     void insert(T v)
     {
         data.insert(v);
-        viz.update_state(v_name, v_type, data, {{to_string(v), "write"}});
-        viz.log_frame("Inserted " + to_string(v) + " into '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::InsertSorted, 0, {}, viz.encode_value(v)}, {{v, VizState::Write}}));
+        V_RECORD(viz.log_frame("Inserted {} into '{}'.", v, v_name));
     }
 
     void erase(T v)
     {
         if (data.count(v) > 0)
         {
-            viz.update_state(v_name, v_type, data, {{to_string(v), "read"}});
-            viz.log_frame("Erasing one instance of " + to_string(v) + " from '" + v_name + "'.");
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Read}}));
+            V_RECORD(viz.log_frame("Erasing one instance of {} from '{}'.", v, v_name));
             data.erase(data.find(v)); // Erase only one instance
-            viz.update_state(v_name, v_type, data);
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::EraseValue, 0, {}, viz.encode_value(v)}));
         }
     }
 };
@@ -949,26 +2350,27 @@ class v_map : public v_base
 public:
     using DataType = map<K, V>;
     map<K, V> data;
+    ~v_map() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty map ---
     v_map(string n) : v_base(n, "map")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty map '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty map '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ map ---
     v_map(string n, const std::map<K, V> &initial_values) : v_base(n, "map"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created map '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created map '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::map ---
     v_map<K, V> &operator=(const std::map<K, V> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to map '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to map '{}'.", v_name));
         return *this;
     }
     v_proxy<v_map, K> operator[](K k) { return v_proxy<v_map, K>(this, k); }
@@ -979,26 +2381,27 @@ class v_multimap : public v_base
 public:
     using DataType = multimap<K, V>;
     multimap<K, V> data;
+    ~v_multimap() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty multimap ---
     v_multimap(string n) : v_base(n, "multimap")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty multimap '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty multimap '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ multimap ---
     v_multimap(string n, const std::multimap<K, V> &initial_values) : v_base(n, "multimap"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created multimap '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created multimap '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::multimap ---
     v_multimap<K, V> &operator=(const std::multimap<K, V> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to multimap '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to multimap '{}'.", v_name));
         return *this;
     }
 
@@ -1006,9 +2409,9 @@ public:
     void insert(pair<K, V> p)
     {
         data.insert(p);
-        viz.update_state(v_name, v_type, data, {{to_string(p.first), "write"}});
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::InsertKey, 0, viz.encode_value(p.first), viz.encode_entry<DataType>(p)}, {{p.first, VizState::Write}}));
         // A more descriptive message for multimap
-        viz.log_frame("Inserted pair (" + to_string(p.first) + ", " + to_string(p.second) + ") into '" + v_name + "'.");
+        V_RECORD(viz.log_frame("Inserted pair ({}, {}) into '{}'.", p.first, p.second, v_name));
     }
 };
 template <typename T>
@@ -1017,53 +2420,56 @@ class v_unordered_set : public v_base
 public:
     using DataType = unordered_set<T>;
     unordered_set<T> data;
+    ~v_unordered_set() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty unordered_set ---
     v_unordered_set(string n) : v_base(n, "unordered_set")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty unordered_set '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty unordered_set '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ unordered_set ---
     v_unordered_set(string n, const std::unordered_set<T> &initial_values) : v_base(n, "unordered_set"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created unordered_set '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created unordered_set '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::unordered_set ---
     v_unordered_set<T> &operator=(const std::unordered_set<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to unordered_set '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to unordered_set '{}'.", v_name));
         return *this;
     }
 
     // --- Visualizable Member Functions ---
     void insert(T v)
     {
-        data.insert(v);
-        viz.update_state(v_name, v_type, data, {{to_string(v), "write"}});
-        viz.log_frame("Inserted " + to_string(v) + " into '" + v_name + "'.");
+        if (data.insert(v).second)
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{v, VizState::Write}}));
+        else
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Write}}));
+        V_RECORD(viz.log_frame("Inserted {} into '{}'.", v, v_name));
     }
 
     void erase(T v)
     {
         if (data.count(v) > 0)
         {
-            viz.update_state(v_name, v_type, data, {{to_string(v), "read"}});
-            viz.log_frame("Erasing " + to_string(v) + " from '" + v_name + "'.");
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Read}}));
+            V_RECORD(viz.log_frame("Erasing {} from '{}'.", v, v_name));
             data.erase(v);
-            viz.update_state(v_name, v_type, data);
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::EraseValue, 0, {}, viz.encode_value(v)}));
         }
     }
 
     bool find(T v)
     {
         bool found = data.count(v) > 0;
-        viz.update_state(v_name, v_type, data, {{to_string(v), "compare"}});
-        viz.log_frame("Finding " + to_string(v) + " in '" + v_name + "'.");
+        V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Compare}}));
+        V_RECORD(viz.log_frame("Finding {} in '{}'.", v, v_name));
         return found;
     }
 };
@@ -1073,26 +2479,27 @@ class v_unordered_multiset : public v_base
 public:
     using DataType = unordered_multiset<T>;
     unordered_multiset<T> data;
+    ~v_unordered_multiset() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty unordered_multiset ---
     v_unordered_multiset(string n) : v_base(n, "unordered_multiset")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty unordered_multiset '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty unordered_multiset '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ unordered_multiset ---
     v_unordered_multiset(string n, const std::unordered_multiset<T> &initial_values) : v_base(n, "unordered_multiset"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created unordered_multiset '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created unordered_multiset '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::unordered_multiset ---
     v_unordered_multiset<T> &operator=(const std::unordered_multiset<T> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to unordered_multiset '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to unordered_multiset '{}'.", v_name));
         return *this;
     }
 
@@ -1100,18 +2507,18 @@ public:
     void insert(T v)
     {
         data.insert(v);
-        viz.update_state(v_name, v_type, data, {{to_string(v), "write"}});
-        viz.log_frame("Inserted " + to_string(v) + " into '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::PushBack, 0, {}, viz.encode_value(v)}, {{v, VizState::Write}}));
+        V_RECORD(viz.log_frame("Inserted {} into '{}'.", v, v_name));
     }
 
     void erase(T v)
     {
         if (data.count(v) > 0)
         {
-            viz.update_state(v_name, v_type, data, {{to_string(v), "read"}});
-            viz.log_frame("Erasing one instance of " + to_string(v) + " from '" + v_name + "'.");
+            V_RECORD(viz.touch(v_name, v_type, data, {{v, VizState::Read}}));
+            V_RECORD(viz.log_frame("Erasing one instance of {} from '{}'.", v, v_name));
             data.erase(data.find(v)); // Erase only one instance
-            viz.update_state(v_name, v_type, data);
+            V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::EraseValue, 0, {}, viz.encode_value(v)}));
         }
     }
 };
@@ -1121,26 +2528,27 @@ class v_unordered_map : public v_base
 public:
     using DataType = unordered_map<K, V>;
     unordered_map<K, V> data;
+    ~v_unordered_map() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty unordered_map ---
     v_unordered_map(string n) : v_base(n, "unordered_map")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty unordered_map '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty unordered_map '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ unordered_map ---
     v_unordered_map(string n, const std::unordered_map<K, V> &initial_values) : v_base(n, "unordered_map"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created unordered_map '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created unordered_map '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::unordered_map ---
     v_unordered_map<K, V> &operator=(const std::unordered_map<K, V> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to unordered_map '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to unordered_map '{}'.", v_name));
         return *this;
     }
 
@@ -1153,26 +2561,27 @@ class v_unordered_multimap : public v_base
 public:
     using DataType = unordered_multimap<K, V>;
     unordered_multimap<K, V> data;
+    ~v_unordered_multimap() { V_RECORD(viz.release(&data)); }
     // --- Constructor 1: Create an empty unordered_multimap ---
     v_unordered_multimap(string n) : v_base(n, "unordered_multimap")
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created empty unordered_multimap '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created empty unordered_multimap '{}'.", v_name));
     }
 
     // --- Constructor 2: Create from a standard C++ unordered_multimap ---
     v_unordered_multimap(string n, const std::unordered_multimap<K, V> &initial_values) : v_base(n, "unordered_multimap"), data(initial_values)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created unordered_multimap '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created unordered_multimap '{}' from initial data.", v_name));
     }
 
     // --- THE NEW FEATURE: Assignment from a std::unordered_multimap ---
     v_unordered_multimap<K, V> &operator=(const std::unordered_multimap<K, V> &new_values)
     {
         this->data = new_values;
-        viz.update_state(v_name, v_type, this->data);
-        viz.log_frame("Assigned new contents to unordered_multimap '" + v_name + "'.");
+        V_RECORD(viz.update_state(v_name, v_type, this->data));
+        V_RECORD(viz.log_frame("Assigned new contents to unordered_multimap '{}'.", v_name));
         return *this;
     }
 
@@ -1180,30 +2589,58 @@ public:
     void insert(pair<K, V> p)
     {
         data.insert(p);
-        viz.update_state(v_name, v_type, data, {{to_string(p.first), "write"}});
-        viz.log_frame("Inserted pair (" + to_string(p.first) + ", " + to_string(p.second) + ") into '" + v_name + "'.");
+        V_RECORD(viz.record_op(v_name, v_type, data, {VizOpKind::InsertKey, 0, viz.encode_value(p.first), viz.encode_entry<DataType>(p)}, {{p.first, VizState::Write}}));
+        V_RECORD(viz.log_frame("Inserted pair ({}, {}) into '{}'.", p.first, p.second, v_name));
     }
 };
+// Stored row-major in one buffer (VizMatrix). Highlight keys: "r-c" for a cell, "r-*" for a
+// whole row, "*-c" for a whole column and "r0-c0:r1-c1" for a rectangle (corners included),
+// so a row or region costs one entry however large the matrix is.
 template <typename T>
 class v_matrix : public v_base
 {
 public:
-    using DataType = vector<vector<T>>;
-    vector<vector<T>> data;
-    v_matrix(string n, vector<vector<T>> iv) : v_base(n, "matrix"), data(iv)
+    using DataType = VizMatrix<T>;
+    DataType data;
+    ~v_matrix() { V_RECORD(viz.release(&data)); }
+    v_matrix(string n, const vector<vector<T>> &iv) : v_base(n, "matrix"), data(iv)
+    {
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created matrix '{}' from initial data.", v_name));
+    }
+    v_matrix(string n, size_t rows, size_t cols, const T &fill) : v_base(n, "matrix"), data(rows, cols, fill)
     {
-        viz.update_state(v_name, v_type, data);
-        viz.log_frame("Created matrix '" + v_name + "' from initial data.");
+        V_RECORD(viz.update_state(v_name, v_type, data));
+        V_RECORD(viz.log_frame("Created {}x{} matrix '{}'.", rows, cols, v_name));
     }
     v_proxy_2d_row<v_matrix> operator[](int r) { return v_proxy_2d_row<v_matrix>(this, r); }
+    size_t rows() const { return data.rows; }
+    size_t cols() const { return data.cols; }
+
+    void highlight_row(size_t r, VizState state = VizState::Read)
+    {
+        V_RECORD(viz.touch(v_name, v_type, data, {VizHighlight::row(r, state)}));
+        V_RECORD(viz.log_frame("Looking at row {} of '{}'.", r, v_name));
+    }
+    void highlight_col(size_t c, VizState state = VizState::Read)
+    {
+        V_RECORD(viz.touch(v_name, v_type, data, {VizHighlight::col(c, state)}));
+        V_RECORD(viz.log_frame("Looking at column {} of '{}'.", c, v_name));
+    }
+    // Rows r0..r1 and columns c0..c1, both inclusive
+    void highlight_region(size_t r0, size_t c0, size_t r1, size_t c1, VizState state = VizState::Read)
+    {
+        V_RECORD(viz.touch(v_name, v_type, data, {VizHighlight::region(r0, c0, r1, c1, state)}));
+        V_RECORD(viz.log_frame("Looking at rows {}-{}, columns {}-{} of '{}'.", r0, r1, c0, c1, v_name));
+    }
 };
 
 // --- Helper for visualizing comparisons (FINAL, POLISHED VERSION) ---
 
 // Base function that does the actual comparison and logging
-int v_compare_base(long long val_a, long long val_b)
+inline int v_compare_base(long long val_a, long long val_b)
 {
-    viz.log_frame("Comparing " + to_string(val_a) + " and " + to_string(val_b));
+    V_RECORD(viz.log_frame("Comparing {} and {}", val_a, val_b));
     if (val_a < val_b)
         return -1;
     if (val_a > val_b)
@@ -1215,8 +2652,8 @@ int v_compare_base(long long val_a, long long val_b)
 template <typename T1, typename T2>
 int v_compare(v_scalar<T1> &a, v_scalar<T2> &b)
 {
-    viz.update_state(a.v_name, a.v_type, a.data, {{"0", "compare"}});
-    viz.update_state(b.v_name, b.v_type, b.data, {{"0", "compare"}});
+    V_RECORD(viz.touch(a.v_name, a.v_type, a.data, {{0, VizState::Compare}}));
+    V_RECORD(viz.touch(b.v_name, b.v_type, b.data, {{0, VizState::Compare}}));
     return v_compare_base(a.data, b.data);
 }
 
@@ -1224,7 +2661,7 @@ int v_compare(v_scalar<T1> &a, v_scalar<T2> &b)
 template <typename T1, typename T2>
 int v_compare(v_scalar<T1> &a, T2 b)
 {
-    viz.update_state(a.v_name, a.v_type, a.data, {{"0", "compare"}});
+    V_RECORD(viz.touch(a.v_name, a.v_type, a.data, {{0, VizState::Compare}}));
     return v_compare_base(a.data, b);
 }
 
@@ -1232,7 +2669,7 @@ int v_compare(v_scalar<T1> &a, T2 b)
 template <typename T1, typename T2>
 int v_compare(T1 a, v_scalar<T2> &b)
 {
-    viz.update_state(b.v_name, b.v_type, b.data, {{"0", "compare"}});
+    V_RECORD(viz.touch(b.v_name, b.v_type, b.data, {{0, VizState::Compare}}));
     return v_compare_base(a, b.data);
 }
 
@@ -1247,7 +2684,7 @@ int v_compare(const v_proxy<P, K> &a, T b)
 template <typename P, typename K, typename T>
 int v_compare(const v_proxy<P, K> &a, v_scalar<T> &b)
 {
-    viz.update_state(b.v_name, b.v_type, b.data, {{"0", "compare"}});
+    V_RECORD(viz.touch(b.v_name, b.v_type, b.data, {{0, VizState::Compare}}));
     return v_compare_base((int)a, b.data);
 }
 
@@ -1260,415 +2697,272 @@ T get(v_scalar<T> &s)
 
 // ########## UNIVERSAL INPUT PARSER & CONTEXT HANDLE ##########
 
-// The InputParser is a self-contained class that turns a string like "arr={1,2}, k=5"
-// into a C++ map that we can easily access.
-class InputParser
-{
-private:
-    string text;
-    size_t pos = 0;
-
-    void skip_whitespace()
-    {
-        while (pos < text.length() && isspace(text[pos]))
-        {
-            pos++;
-        }
-    }
-
-    // Parses a variable name like 'arr', 'k', 'my_matrix'
-    string parse_key()
-    {
-        skip_whitespace();
-        size_t start = pos;
-        if (pos < text.length() && isalpha(text[pos]))
-        {
-            pos++;
-            while (pos < text.length() && (isalnum(text[pos]) || text[pos] == '_'))
-            {
-                pos++;
-            }
-        }
-        return text.substr(start, pos - start);
-    }
-
-    // The main function that decides what kind of value to parse next
-    json parse_value()
-    {
-        skip_whitespace();
-        if (pos >= text.length())
-            throw runtime_error("Unexpected end of input, expected a value.");
-
-        char current = text[pos];
-        if (current == '{')
-        {
-            pos++; // Consume '{'
-            return parse_array_or_matrix();
-        }
-        if (current == '"')
-        {
-            pos++; // Consume '"'
-            return parse_string();
-        }
-        if (isdigit(current) || current == '-')
-        {
-            return parse_number();
-        }
-        if (isalpha(current))
-        {
-            string literal = parse_key();
-            if (literal == "true")
-                return true;
-            if (literal == "false")
-                return false;
-            throw runtime_error("Invalid value token: " + literal);
-        }
-
-        throw runtime_error("Invalid character in value: " + string(1, current));
-    }
-
-    // Parses a string value, e.g., "Hello World"
-    json parse_string()
-    {
-        size_t start = pos;
-        while (pos < text.length() && text[pos] != '"')
-        {
-            pos++;
-        }
-        if (pos >= text.length())
-            throw runtime_error("Unterminated string literal.");
-        string val = text.substr(start, pos - start);
-        pos++; // Consume closing '"'
-        return val;
-    }
-
-    // Parses a number, can be integer or floating point
-    json parse_number()
-    {
-        size_t start = pos;
-        if (text[pos] == '-')
-            pos++;
-        while (pos < text.length() && isdigit(text[pos]))
-            pos++;
-        if (pos < text.length() && text[pos] == '.')
-        {
-            pos++;
-            while (pos < text.length() && isdigit(text[pos]))
-                pos++;
-            return stod(text.substr(start, pos - start));
-        }
-        return stoll(text.substr(start, pos - start)); // Use stoll for long long
-    }
-
-    // Parses an array like {1,2,3} or a matrix like {{1,2},{3,4}}
-    json parse_array_or_matrix()
-    {
-        skip_whitespace();
-        if (text[pos] == '}')
-        { // Empty array {}
-            pos++;
-            return json::array();
-        }
-
-        json arr = json::array();
-        while (pos < text.length())
-        {
-            arr.push_back(parse_value());
-            skip_whitespace();
-            if (text[pos] == '}')
-            {
-                pos++; // End of array
-                return arr;
-            }
-            if (text[pos] == ',')
-            {
-                pos++; // Continue to next element
-                continue;
-            }
-            throw runtime_error("Expected ',' or '}' in array declaration.");
-        }
-        throw runtime_error("Unterminated array declaration.");
-    }
-
-public:
-    // The only public function. Takes the raw string and returns the parsed map.
-    map<string, json> parse(const string &input)
-    {
-        text = input;
-        pos = 0;
-        map<string, json> result;
-
-        while (pos < text.length())
-        {
-            string name = parse_key();
-            if (name.empty())
-            {
-                skip_whitespace();
-                if (pos < text.length())
-                    throw runtime_error("Unexpected token at start of input.");
-                break;
-            }
-
-            skip_whitespace();
-            if (pos >= text.length() || text[pos] != '=')
-            {
-                throw runtime_error("Expected '=' after key '" + name + "'.");
-            }
-            pos++; // Consume '='
-
-            result[name] = parse_value();
-            skip_whitespace();
-            if (pos < text.length() && text[pos] == ',')
-            {
-                pos++;
-            }
-        }
-        return result;
-    }
-};
+// The parsed input, see InputParser (v-cpp/parser.hpp)
+struct VizInput;
 
 // The VCtx (Visualizer Context) easy-to-use handle for getting data.
 class VCtx
 {
 private:
-    map<string, json> p_input; // Holds the parsed data
+    shared_ptr<const VizInput> p_input; // Holds the parsed data
+
+    bool has_input(const string &name) const;
+    // The input `name` converted to T. Defined with the parser; a prebuilt v-cpp.o only has the
+    // types v-cpp.cpp instantiates.
+    template <typename T>
+    T input(const string &name) const;
 
-    // Helper to log creation of new objects
+    // Helper to log creation of new objects, at the recording level asked for
     template <typename T, typename... Args>
-    T create_and_log(Args &&...args)
+    T create_and_log(VizLevel level, const string &name, Args &&...args)
     {
-        T obj(std::forward<Args>(args)...);
+        viz.set_level(name, level); // First: the constructor's own frame already follows it
+        T obj(name, std::forward<Args>(args)...);
         // The constructors of v_ objects already log, so we don't need to log here.
         return obj;
     }
 
 public:
-    VCtx(map<string, json> parsed_input) : p_input(std::move(parsed_input)) {}
+    // Parses the universal input, e.g. "arr={1,2}, k=5"; throws runtime_error on malformed input
+    explicit VCtx(const string &raw_input);
+
+    // --- Run Settings ---
+    // Caps the number of frames this run produces (0 = unlimited). See VizEngine::frame_budget.
+    void set_frame_budget(size_t max_frames) { viz.frame_budget = max_frames; }
+    // Records no frames, only counts the operations on every object; visualizeMyLogic then
+    // returns that report instead of the history. See VizProfile.
+    void set_profiling(bool on = true) { viz.profiling = on; }
 
     // --- Scalar Functions ---
     template <typename T>
-    v_scalar<T> get_scalar(string name, T default_value = T{})
+    v_scalar<T> get_scalar(string name, T default_value = T{}, VizLevel level = VizLevel::Full)
     {
-        T value = p_input.count(name) ? p_input[name].get<T>() : default_value;
-        return create_and_log<v_scalar<T>>(name, value);
+        T value = has_input(name) ? input<T>(name) : default_value;
+        return create_and_log<v_scalar<T>>(level, name, value);
     }
     template <typename T>
-    v_scalar<T> new_scalar(string name, T initial_value = T{})
+    v_scalar<T> new_scalar(string name, T initial_value = T{}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_scalar<T>>(name, initial_value);
+        return create_and_log<v_scalar<T>>(level, name, initial_value);
     }
 
     // --- Vector Functions ---
     template <typename T>
-    v_vector<T> get_vector(string name)
+    v_vector<T> get_vector(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
         {
             throw runtime_error("Input error: required vector '" + name + "' was not provided.");
         }
-        return create_and_log<v_vector<T>>(name, p_input[name].get<vector<T>>());
+        return create_and_log<v_vector<T>>(level, name, input<vector<T>>(name));
     }
     template <typename T>
-    v_vector<T> new_vector(string name, const std::vector<T> &iv = {})
+    v_vector<T> new_vector(string name, const std::vector<T> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_vector<T>>(name, iv);
+        return create_and_log<v_vector<T>>(level, name, iv);
     }
 
     // --- Matrix Functions ---
     template <typename T>
-    v_matrix<T> get_matrix(string name)
+    v_matrix<T> get_matrix(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
         {
             throw runtime_error("Input error: required matrix '" + name + "' was not provided.");
         }
-        return create_and_log<v_matrix<T>>(name, p_input[name].get<vector<vector<T>>>());
+        return create_and_log<v_matrix<T>>(level, name, input<vector<vector<T>>>(name));
+    }
+    template <typename T>
+    v_matrix<T> new_matrix(string name, const std::vector<vector<T>> &iv = {}, VizLevel level = VizLevel::Full)
+    {
+        return create_and_log<v_matrix<T>>(level, name, iv);
     }
+    // A rows x cols table filled with `fill`, e.g. a DP table
     template <typename T>
-    v_matrix<T> new_matrix(string name, const std::vector<vector<T>> &iv = {})
+    v_matrix<T> new_matrix(string name, size_t rows, size_t cols, const T &fill = T{}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_matrix<T>>(name, iv);
+        return create_and_log<v_matrix<T>>(level, name, rows, cols, fill);
     }
 
     // --- NEW: List Functions ---
     template <typename T>
-    v_list<T> get_list(string name)
+    v_list<T> get_list(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
         {
             throw runtime_error("Input error: required list '" + name + "' was not provided.");
         }
-        return create_and_log<v_list<T>>(name, p_input[name].get<list<T>>());
+        return create_and_log<v_list<T>>(level, name, input<list<T>>(name));
     }
     template <typename T>
-    v_list<T> new_list(string name, const std::list<T> &iv = {})
+    v_list<T> new_list(string name, const std::list<T> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_list<T>>(name, iv);
+        return create_and_log<v_list<T>>(level, name, iv);
     }
 
     // --- NEW: Deque Functions ---
     template <typename T>
-    v_deque<T> get_deque(string name)
+    v_deque<T> get_deque(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
         {
             throw runtime_error("Input error: required deque '" + name + "' was not provided.");
         }
-        return create_and_log<v_deque<T>>(name, p_input[name].get<deque<T>>());
+        return create_and_log<v_deque<T>>(level, name, input<deque<T>>(name));
     }
     template <typename T>
-    v_deque<T> new_deque(string name, const std::deque<T> &iv = {})
+    v_deque<T> new_deque(string name, const std::deque<T> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_deque<T>>(name, iv);
+        return create_and_log<v_deque<T>>(level, name, iv);
     }
 
     // --- NEW: Stack Functions ---
     // Note: Stacks are often created empty or from other containers, not directly from input.
     template <typename T>
-    v_stack<T> new_stack(string name)
+    v_stack<T> new_stack(string name, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_stack<T>>(name);
+        return create_and_log<v_stack<T>>(level, name);
     }
     template <typename T, typename Container>
-    v_stack<T> new_stack(string name, const Container &iv)
+    v_stack<T> new_stack(string name, const Container &iv, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_stack<T>>(name, iv);
+        return create_and_log<v_stack<T>>(level, name, iv);
     }
 
     // --- NEW: Queue Functions ---
     template <typename T>
-    v_queue<T> new_queue(string name)
+    v_queue<T> new_queue(string name, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_queue<T>>(name);
+        return create_and_log<v_queue<T>>(level, name);
     }
     template <typename T, typename Container>
-    v_queue<T> new_queue(string name, const Container &iv)
+    v_queue<T> new_queue(string name, const Container &iv, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_queue<T>>(name, iv);
+        return create_and_log<v_queue<T>>(level, name, iv);
     }
 
     // --- NEW: Priority Queue Functions ---
     template <typename T>
-    v_priority_queue<T> new_priority_queue(string name)
+    v_priority_queue<T> new_priority_queue(string name, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_priority_queue<T>>(name);
+        return create_and_log<v_priority_queue<T>>(level, name);
     }
     template <typename T, typename Container>
-    v_priority_queue<T> new_priority_queue(string name, const Container &iv)
+    v_priority_queue<T> new_priority_queue(string name, const Container &iv, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_priority_queue<T>>(name, iv);
+        return create_and_log<v_priority_queue<T>>(level, name, iv);
     }
 
     // --- NEW: Set Functions ---
     template <typename T>
-    v_set<T> get_set(string name)
+    v_set<T> get_set(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("Input error: required set '" + name + "' was not provided.");
         // We get a vector from JSON and construct the set from it
-        auto vec = p_input[name].get<vector<T>>();
-        return create_and_log<v_set<T>>(name, std::set<T>(vec.begin(), vec.end()));
+        auto vec = input<vector<T>>(name);
+        return create_and_log<v_set<T>>(level, name, std::set<T>(vec.begin(), vec.end()));
     }
     template <typename T>
-    v_set<T> new_set(string name, const std::set<T> &iv = {})
+    v_set<T> new_set(string name, const std::set<T> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_set<T>>(name, iv);
+        return create_and_log<v_set<T>>(level, name, iv);
     }
 
     // --- NEW: Multiset Functions ---
     template <typename T>
-    v_multiset<T> get_multiset(string name)
+    v_multiset<T> get_multiset(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("Input error: required multiset '" + name + "' was not provided.");
-        auto vec = p_input[name].get<vector<T>>();
-        return create_and_log<v_multiset<T>>(name, std::multiset<T>(vec.begin(), vec.end()));
+        auto vec = input<vector<T>>(name);
+        return create_and_log<v_multiset<T>>(level, name, std::multiset<T>(vec.begin(), vec.end()));
     }
     template <typename T>
-    v_multiset<T> new_multiset(string name, const std::multiset<T> &iv = {})
+    v_multiset<T> new_multiset(string name, const std::multiset<T> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_multiset<T>>(name, iv);
+        return create_and_log<v_multiset<T>>(level, name, iv);
     }
 
     // --- NEW: Map Functions ---
     // Note: Getting a map from JSON is tricky. The parser creates an array of key-value pairs.
     // We expect the input to be like: my_map={{key,val},{key,val}} which the parser handles as a vector of vectors.
     template <typename K, typename V>
-    v_map<K, V> get_map(string name)
+    v_map<K, V> get_map(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("Input error: required map '" + name + "' was not provided.");
-        auto vec_of_pairs = p_input[name].get<vector<pair<K, V>>>(); // Requires a custom JSON->pair conversion
-        return create_and_log<v_map<K, V>>(name, std::map<K, V>(vec_of_pairs.begin(), vec_of_pairs.end()));
+        auto vec_of_pairs = input<vector<pair<K, V>>>(name); // Requires a custom JSON->pair conversion
+        return create_and_log<v_map<K, V>>(level, name, std::map<K, V>(vec_of_pairs.begin(), vec_of_pairs.end()));
     }
     template <typename K, typename V>
-    v_map<K, V> new_map(string name, const std::map<K, V> &iv = {})
+    v_map<K, V> new_map(string name, const std::map<K, V> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_map<K, V>>(name, iv);
+        return create_and_log<v_map<K, V>>(level, name, iv);
     }
 
     // --- NEW: Multimap Functions ---
     template <typename K, typename V>
-    v_multimap<K, V> get_multimap(string name)
+    v_multimap<K, V> get_multimap(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("Input error: required multimap '" + name + "' was not provided.");
-        auto vec_of_pairs = p_input[name].get<vector<pair<K, V>>>();
-        return create_and_log<v_multimap<K, V>>(name, std::multimap<K, V>(vec_of_pairs.begin(), vec_of_pairs.end()));
+        auto vec_of_pairs = input<vector<pair<K, V>>>(name);
+        return create_and_log<v_multimap<K, V>>(level, name, std::multimap<K, V>(vec_of_pairs.begin(), vec_of_pairs.end()));
     }
     template <typename K, typename V>
-    v_multimap<K, V> new_multimap(string name, const std::multimap<K, V> &iv = {})
+    v_multimap<K, V> new_multimap(string name, const std::multimap<K, V> &iv = {}, VizLevel level = VizLevel::Full)
     {
-        return create_and_log<v_multimap<K, V>>(name, iv);
+        return create_and_log<v_multimap<K, V>>(level, name, iv);
     }
 
     // --- NEW: Unordered Set Functions ---
     template <typename T>
-    v_unordered_set<T> get_unordered_set(string name)
+    v_unordered_set<T> get_unordered_set(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("... '" + name + "' ...");
-        auto vec = p_input[name].get<vector<T>>();
-        return create_and_log<v_unordered_set<T>>(name, std::unordered_set<T>(vec.begin(), vec.end()));
+        auto vec = input<vector<T>>(name);
+        return create_and_log<v_unordered_set<T>>(level, name, std::unordered_set<T>(vec.begin(), vec.end()));
     }
     template <typename T>
-    v_unordered_set<T> new_unordered_set(string name, const std::unordered_set<T> &iv = {}) { return create_and_log<v_unordered_set<T>>(name, iv); }
+    v_unordered_set<T> new_unordered_set(string name, const std::unordered_set<T> &iv = {}, VizLevel level = VizLevel::Full) { return create_and_log<v_unordered_set<T>>(level, name, iv); }
 
     // --- NEW: Unordered Multiset Functions ---
     template <typename T>
-    v_unordered_multiset<T> get_unordered_multiset(string name)
+    v_unordered_multiset<T> get_unordered_multiset(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("... '" + name + "' ...");
-        auto vec = p_input[name].get<vector<T>>();
-        return create_and_log<v_unordered_multiset<T>>(name, std::unordered_multiset<T>(vec.begin(), vec.end()));
+        auto vec = input<vector<T>>(name);
+        return create_and_log<v_unordered_multiset<T>>(level, name, std::unordered_multiset<T>(vec.begin(), vec.end()));
     }
     template <typename T>
-    v_unordered_multiset<T> new_unordered_multiset(string name, const std::unordered_multiset<T> &iv = {}) { return create_and_log<v_unordered_multiset<T>>(name, iv); }
+    v_unordered_multiset<T> new_unordered_multiset(string name, const std::unordered_multiset<T> &iv = {}, VizLevel level = VizLevel::Full) { return create_and_log<v_unordered_multiset<T>>(level, name, iv); }
 
     // --- NEW: Unordered Map Functions ---
     template <typename K, typename V>
-    v_unordered_map<K, V> get_unordered_map(string name)
+    v_unordered_map<K, V> get_unordered_map(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("... '" + name + "' ...");
-        auto v_p = p_input[name].get<vector<pair<K, V>>>();
-        return create_and_log<v_unordered_map<K, V>>(name, std::unordered_map<K, V>(v_p.begin(), v_p.end()));
+        auto v_p = input<vector<pair<K, V>>>(name);
+        return create_and_log<v_unordered_map<K, V>>(level, name, std::unordered_map<K, V>(v_p.begin(), v_p.end()));
     }
     template <typename K, typename V>
-    v_unordered_map<K, V> new_unordered_map(string name, const std::unordered_map<K, V> &iv = {}) { return create_and_log<v_unordered_map<K, V>>(name, iv); }
+    v_unordered_map<K, V> new_unordered_map(string name, const std::unordered_map<K, V> &iv = {}, VizLevel level = VizLevel::Full) { return create_and_log<v_unordered_map<K, V>>(level, name, iv); }
 
     // --- NEW: Unordered Multimap Functions ---
     template <typename K, typename V>
-    v_unordered_multimap<K, V> get_unordered_multimap(string name)
+    v_unordered_multimap<K, V> get_unordered_multimap(string name, VizLevel level = VizLevel::Full)
     {
-        if (!p_input.count(name))
+        if (!has_input(name))
             throw runtime_error("... '" + name + "' ...");
-        auto v_p = p_input[name].get<vector<pair<K, V>>>();
-        return create_and_log<v_unordered_multimap<K, V>>(name, std::unordered_multimap<K, V>(v_p.begin(), v_p.end()));
+        auto v_p = input<vector<pair<K, V>>>(name);
+        return create_and_log<v_unordered_multimap<K, V>>(level, name, std::unordered_multimap<K, V>(v_p.begin(), v_p.end()));
     }
     template <typename K, typename V>
-    v_unordered_multimap<K, V> new_unordered_multimap(string name, const std::unordered_multimap<K, V> &iv = {}) { return create_and_log<v_unordered_multimap<K, V>>(name, iv); }
+    v_unordered_multimap<K, V> new_unordered_multimap(string name, const std::unordered_multimap<K, V> &iv = {}, VizLevel level = VizLevel::Full) { return create_and_log<v_unordered_multimap<K, V>>(level, name, iv); }
 };
 
 // ===============================================
@@ -1681,42 +2975,37 @@ public:
 // The user of the library MUST define this function.
 void run_my_algorithm(VCtx& v);
 
-// --- Your PLAYGROUND: Write your code here ---
-std::string visualizeMyLogic(const std::string &raw_input)
-{
-    // ================================================================
-    // BOILERPLATE START: This runs automatically before your code.
-    // ================================================================
-
-    viz.reset(); // Reset the engine for a new run
-
-    try {
-        // Setup Phase
-        InputParser parser;
-        map<string, json> parsed_input = parser.parse(raw_input);
-        VCtx v(parsed_input); 
-
-        viz.log_frame("Successfully parsed input.");
-
-        // ================================================================
-        // EXECUTION: Your personal algorithm function is called here.
-        run_my_algorithm(v); 
-        // ================================================================
-
-    } catch (const std::exception& e) {
-        viz.log_frame("Error: " + string(e.what()));
-    }
-
-    // ================================================================
-    // BOILERPLATE END: This runs automatically after your code.
-    // ================================================================
-    return viz.history.dump(); // <-- STEP 2: The history is returned HERE.
-}
-
-// ##### EMSCRIPTEN BINDINGS #####
-EMSCRIPTEN_BINDINGS(my_module)
-{
-    emscripten::function("visualizeMyLogic", &visualizeMyLogic);
-}
+// --- Your PLAYGROUND: the entry points, defined in v-cpp/bindings.hpp ---
+// Parses the input, runs run_my_algorithm and finishes the history in `viz`
+V_CPP_INLINE void run_visualization(const std::string &raw_input);
+
+// The JSON history of one run, of at most `frame_budget` frames (0 = unlimited)
+V_CPP_INLINE std::string visualizeMyLogicWithBudget(const std::string &raw_input, int frame_budget);
+V_CPP_INLINE std::string visualizeMyLogic(const std::string &raw_input);
+
+// --- The history with what it took in memory: {"stats": {...}, "history": [...]} ---
+// The stats are taken before the export, see VizEngine::dump_stats for their shape.
+V_CPP_INLINE std::string visualizeMyLogicWithStats(const std::string &raw_input, int frame_budget);
+
+// --- Profiling variant: no frames, only the operation counts of every object, as JSON ---
+// For inputs too large to animate. See VizEngine::dump_profile for the report's shape.
+V_CPP_INLINE std::string visualizeMyLogicProfile(const std::string &raw_input);
+
+// --- The same history in the compact "VCPB" format ---
+V_CPP_INLINE std::string visualizeMyLogicBinaryString(const std::string &raw_input, int frame_budget = VizEngine::default_frame_budget);
+
+// --- Streaming to any sink: `on_chunk` gets every chunk of up to `frames_per_chunk` frames ---
+// Returns the total number of frames.
+V_CPP_INLINE int visualizeMyLogicStreamingTo(const std::string &raw_input, function<void(const string &)> on_chunk, int frames_per_chunk,
+                                             HistoryFormat format = HistoryFormat::Json, int frame_budget = VizEngine::default_frame_budget);
+
+// --- The implementation ---
+// Header-only: compiled here, with the algorithm. Prebuilt: in v-cpp.o, see src/cpp/v-cpp.cpp.
+#ifndef V_CPP_PREBUILT
+#include "v-cpp/engine.hpp"
+#include "v-cpp/serializer.hpp"
+#include "v-cpp/parser.hpp"
+#include "v-cpp/bindings.hpp"
+#endif
 
 #endif // V_CPP_HPP
\ No newline at end of file
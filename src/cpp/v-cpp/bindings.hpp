@@ -0,0 +1,132 @@
+#ifndef V_CPP_BINDINGS_HPP
+#define V_CPP_BINDINGS_HPP
+
+// ########## Bindings: the entry points the app calls ##########
+// Every visualizeMyLogic variant, and their Emscripten bindings. Declared in v-cpp.hpp.
+// Part of the engine's implementation: included by v-cpp.hpp in the header-only build, compiled
+// into v-cpp.o by v-cpp.cpp in the prebuilt one (see the README).
+
+#include "../v-cpp.hpp"
+#ifdef __EMSCRIPTEN__
+#include <emscripten/bind.h>
+#endif
+
+V_CPP_INLINE void run_visualization(const std::string &raw_input)
+{
+    // ================================================================
+    // BOILERPLATE START: This runs automatically before your code.
+    // ================================================================
+
+    try {
+        // Setup Phase
+        VCtx v(raw_input);
+
+        viz.log_frame("Successfully parsed input.");
+
+        // ================================================================
+        // EXECUTION: Your personal algorithm function is called here.
+        run_my_algorithm(v); 
+        // ================================================================
+
+    } catch (const std::exception& e) {
+        viz.log_frame("Error: {}", e.what());
+        viz.profile.error = e.what();
+    }
+
+    // ================================================================
+    // BOILERPLATE END: This runs automatically after your code.
+    // ================================================================
+    viz.finish();
+}
+
+V_CPP_INLINE std::string visualizeMyLogicWithBudget(const std::string &raw_input, int frame_budget)
+{
+    viz.reset(); // Reset the engine for a new run
+    viz.frame_budget = max(frame_budget, 0);
+    run_visualization(raw_input);
+    if (viz.profiling)
+        return viz.dump_profile(); // The algorithm asked for counts only (VCtx::set_profiling)
+    return viz.dump_history(); // <-- STEP 2: The history is returned HERE.
+}
+
+V_CPP_INLINE std::string visualizeMyLogic(const std::string &raw_input)
+{
+    return visualizeMyLogicWithBudget(raw_input, VizEngine::default_frame_budget);
+}
+
+V_CPP_INLINE std::string visualizeMyLogicWithStats(const std::string &raw_input, int frame_budget)
+{
+    viz.reset();
+    viz.frame_budget = max(frame_budget, 0);
+    run_visualization(raw_input);
+    string out = "{\"stats\":" + viz.dump_stats() + ",\"history\":";
+    viz.dump_history(out);
+    out += '}';
+    return out;
+}
+
+V_CPP_INLINE std::string visualizeMyLogicProfile(const std::string &raw_input)
+{
+    viz.reset();
+    viz.profiling = true;
+    run_visualization(raw_input);
+    return viz.dump_profile();
+}
+
+V_CPP_INLINE std::string visualizeMyLogicBinaryString(const std::string &raw_input, int frame_budget)
+{
+    viz.reset();
+    viz.frame_budget = max(frame_budget, 0);
+    run_visualization(raw_input);
+    return viz.dump_history_binary();
+}
+
+V_CPP_INLINE int visualizeMyLogicStreamingTo(const std::string &raw_input, function<void(const string &)> on_chunk, int frames_per_chunk,
+                                             HistoryFormat format, int frame_budget)
+{
+    viz.reset();
+    viz.frame_budget = max(frame_budget, 0);
+    viz.stream_to(std::move(on_chunk), max(frames_per_chunk, 1), format);
+    run_visualization(raw_input);
+    return (int)viz.frame_count();
+}
+
+#ifdef __EMSCRIPTEN__
+// --- Binary variant: the VCPB history as a Uint8Array ---
+// Decode it with decodeHistory() from src/historyDecoder.js.
+emscripten::val visualizeMyLogicBinary(const std::string &raw_input)
+{
+    string bytes = visualizeMyLogicBinaryString(raw_input);
+    // Copy out of the Wasm heap, the view would be invalidated by the next allocation
+    return emscripten::val::global("Uint8Array").new_(emscripten::typed_memory_view(bytes.size(), reinterpret_cast<const uint8_t *>(bytes.data())));
+}
+
+// --- Streaming variant: frames are passed to `on_chunk` as JSON arrays while the algorithm runs ---
+// Only one chunk of frames lives in Wasm memory at a time. Returns the total number of frames.
+int visualizeMyLogicStreaming(const std::string &raw_input, emscripten::val on_chunk, int frames_per_chunk)
+{
+    return visualizeMyLogicStreamingTo(raw_input, [&on_chunk](const string &chunk) { on_chunk(chunk); }, frames_per_chunk);
+}
+
+// Same as above with binary chunks (Uint8Array), each one decodable by HistoryDecoder.decodeChunk()
+int visualizeMyLogicStreamingBinary(const std::string &raw_input, emscripten::val on_chunk, int frames_per_chunk)
+{
+    return visualizeMyLogicStreamingTo(raw_input, [&on_chunk](const string &chunk)
+                                       { on_chunk(emscripten::val::global("Uint8Array").new_(emscripten::typed_memory_view(chunk.size(), reinterpret_cast<const uint8_t *>(chunk.data())))); },
+                                       frames_per_chunk, HistoryFormat::Binary);
+}
+
+// ##### EMSCRIPTEN BINDINGS #####
+EMSCRIPTEN_BINDINGS(my_module)
+{
+    emscripten::function("visualizeMyLogic", &visualizeMyLogic);
+    emscripten::function("visualizeMyLogicWithBudget", &visualizeMyLogicWithBudget);
+    emscripten::function("visualizeMyLogicWithStats", &visualizeMyLogicWithStats);
+    emscripten::function("visualizeMyLogicProfile", &visualizeMyLogicProfile);
+    emscripten::function("visualizeMyLogicStreaming", &visualizeMyLogicStreaming);
+    emscripten::function("visualizeMyLogicBinary", &visualizeMyLogicBinary);
+    emscripten::function("visualizeMyLogicStreamingBinary", &visualizeMyLogicStreamingBinary);
+}
+#endif // __EMSCRIPTEN__
+
+#endif // V_CPP_BINDINGS_HPP
@@ -0,0 +1,315 @@
+#ifndef V_CPP_ENGINE_HPP
+#define V_CPP_ENGINE_HPP
+
+// ########## Engine: recording, frame budget and memory accounting ##########
+// The members of VizEngine that record the frames, and the profiling report.
+// Part of the engine's implementation: included by v-cpp.hpp in the header-only build, compiled
+// into v-cpp.o by v-cpp.cpp in the prebuilt one (see the README).
+
+#include "../v-cpp.hpp"
+#include "../include/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// --- Recording ---
+V_CPP_INLINE void VizEngine::reset()
+{
+    history.clear();
+    object_states.clear();
+    dirty_objects.clear();
+    changed_objects.clear();
+    dropped_frames = 0;
+    sampled_frames = 0;
+    last_dropped_args.clear();
+    chunk_sink = nullptr;
+    flushed_frames = 0;
+    strings.clear();
+    message_args.clear();
+    stream_writer = HistoryWriter(*this);
+    stream_binary_writer = BinaryHistoryWriter(*this);
+    profiling = false;
+    profile.clear();
+    levels.clear();
+    frame_request = FrameRequest::None;
+    group_depth = 0;
+    frame_object_bytes = 0;
+    memory.clear(); // After everything holding a snapshot is gone
+    arena.reset(); // Last: nothing above may still hold a frame or snapshot
+}
+
+V_CPP_INLINE void VizEngine::finish()
+{
+    if (dropped_frames > 0)
+    {
+        dropped_frames--; // The last dropped frame is kept after all, it does not count itself
+        uint32_t first = static_cast<uint32_t>(message_args.size());
+        message_args.insert(message_args.end(), last_dropped_args.begin(), last_dropped_args.end());
+        push_frame(last_dropped_message, first);
+    }
+    if (chunk_sink && !history.empty())
+    {
+        flush_chunk();
+    }
+}
+
+V_CPP_INLINE void VizEngine::release(const void *source)
+{
+    for (auto it = dirty_objects.begin(); it != dirty_objects.end();)
+    {
+        if (it->second.source == source)
+        {
+            commit(it->first, it->second);
+            it = dirty_objects.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+V_CPP_INLINE VizMemoryStats VizEngine::stats() const
+{
+    VizMemoryStats current = memory;
+    current.frames = frame_bytes();
+    current.strings = strings.bytes();
+    current.arena = arena.reserved();
+    current.outside_arena = outside_arena_bytes();
+    current.peak = max(current.peak, current.footprint());
+    return current;
+}
+
+V_CPP_INLINE string VizEngine::dump_stats() const
+{
+    VizMemoryStats current = stats();
+    json objects = json::object();
+    const auto &by_name = current.objects();
+    for (uint32_t name = 0; name < by_name.size(); ++name)
+    {
+        if (by_name[name].peak > 0)
+            objects[strings[name]] = {{"live", by_name[name].live}, {"peak", by_name[name].peak}, {"versions", by_name[name].versions}};
+    }
+    return json{{"footprint", current.footprint()},
+                {"peak", current.peak},
+                {"peak_frame", current.peak_frame},
+                {"live", current.live()},
+                {"snapshots", current.snapshots},
+                {"frames", current.frames},
+                {"strings", current.strings},
+                {"arena", current.arena},
+                {"outside_arena", current.outside_arena},
+                {"objects", std::move(objects)}}
+        .dump();
+}
+
+V_CPP_INLINE string VizEngine::dump_profile() const
+{
+    return profile.report();
+}
+
+V_CPP_INLINE void VizEngine::stream_to(function<void(const string &)> sink, size_t frames_per_chunk, HistoryFormat format)
+{
+    chunk_sink = std::move(sink);
+    chunk_frames = max<size_t>(frames_per_chunk, 1);
+    chunk_format = format;
+}
+
+V_CPP_INLINE void VizEngine::commit(const string &name, PendingUpdate &pending)
+{
+    auto &current = object_states[name];
+    auto snapshot = allocate_shared<VizSnapshot>(pmr::polymorphic_allocator<VizSnapshot>(&arena), &arena);
+    snapshot->name = strings.intern(name);
+    snapshot->version = current ? current->version + 1 : 0;
+    snapshot->type = strings.intern(pending.type);
+    snapshot->highlights.reserve(pending.highlights.size() + pending.group_highlights.size());
+    auto add_highlight = [&](const VizHighlight &h)
+    {
+        char key[VizHighlight::max_key_chars];
+        uint32_t key_id = h.kind == VizHighlight::Text ? static_cast<uint32_t>(h.at[0]) : strings.intern(h.format(key));
+        snapshot->highlights.emplace_back(key_id, strings.intern(state_name(h.state)));
+    };
+    for (const auto &h : pending.highlights)
+        add_highlight(h);
+    for_each(pending.group_highlights.rbegin(), pending.group_highlights.rend(), add_highlight); // Newest first: a group shows a key's last state
+    if (snapshot->highlights.size() > 1)
+    {
+        // Sorted by key text like a json object, the first highlight of a key wins
+        auto by_key = [&](const auto &a, const auto &b) { return strings[a.first] < strings[b.first]; };
+        stable_sort(snapshot->highlights.begin(), snapshot->highlights.end(), by_key);
+        auto last = unique(snapshot->highlights.begin(), snapshot->highlights.end(), [](const auto &a, const auto &b) { return a.first == b.first; });
+        snapshot->highlights.erase(last, snapshot->highlights.end());
+    }
+    if (!pending.full && current && current->depth + 1 < delta_limit(current.get()))
+    {
+        snapshot->full = false;
+        snapshot->base = current;
+        snapshot->ops.assign(make_move_iterator(pending.ops.begin()), make_move_iterator(pending.ops.end()));
+        snapshot->depth = current->depth + 1;
+        snapshot->full_size = current->full_size;
+    }
+    else
+    {
+        scratch.clear();
+        pending.serialize(scratch);
+        snapshot->data.assign(scratch);
+        snapshot->full_size = scratch.size();
+    }
+    snapshot->report_to(memory);
+    current = std::move(snapshot);
+    changed_objects.insert(name);
+    note_memory();
+}
+
+V_CPP_INLINE void VizEngine::commit_dirty()
+{
+    for (auto &[name, pending] : dirty_objects)
+    {
+        commit(name, pending);
+    }
+    dirty_objects.clear();
+}
+
+V_CPP_INLINE bool VizEngine::is_structural_frame() const
+{
+    if (dirty_objects.empty())
+        return true;
+    for (const auto &[name, pending] : dirty_objects)
+    {
+        if (pending.full || !pending.ops.empty())
+            return true;
+    }
+    return false;
+}
+
+V_CPP_INLINE bool VizEngine::keep_frame()
+{
+    size_t limit = frame_budget - 1; // The last slot is kept for finish()
+    size_t count = frame_count();
+    if (count >= limit)
+        return false;
+    size_t half = limit / 2;
+    if (count < half || is_structural_frame())
+        return true;
+
+    size_t remaining = limit - count;
+    size_t stride = 2;
+    while (stride * remaining < half)
+        stride *= 2;
+    return ++sampled_frames % stride == 0;
+}
+
+V_CPP_INLINE void VizEngine::push_frame(uint32_t message, uint32_t first_arg)
+{
+    commit_dirty();
+
+    VizFrame frame(&arena);
+    frame.message = message;
+    frame.first_arg = first_arg;
+    frame.arg_count = static_cast<uint32_t>(message_args.size()) - first_arg;
+    // The first frame after a streamed chunk is always a keyframe, so history can be rebuilt on its own
+    frame.keyframe = history_mode == HistoryMode::Full || history.empty() || frame_count() % keyframe_interval == 0;
+    frame.dropped = dropped_frames;
+    dropped_frames = 0;
+
+    if (frame.keyframe)
+    {
+        frame.objects.reserve(object_states.size());
+        for (const auto &[name, snapshot] : object_states)
+        {
+            frame.objects.push_back(snapshot);
+        }
+    }
+    else
+    {
+        frame.objects.reserve(changed_objects.size());
+        for (const auto &name : changed_objects)
+        {
+            frame.objects.push_back(object_states.at(name));
+        }
+    }
+    changed_objects.clear();
+    frame_object_bytes += frame.objects.capacity() * sizeof(VizSnapshotPtr);
+    history.push_back(std::move(frame));
+    note_memory();
+
+    if (chunk_sink && history.size() >= chunk_frames)
+    {
+        flush_chunk();
+    }
+}
+
+V_CPP_INLINE size_t VizEngine::frame_bytes() const
+{
+    return history.capacity() * sizeof(VizFrame) + frame_object_bytes + message_args.capacity() * sizeof(VizArg);
+}
+
+V_CPP_INLINE size_t VizEngine::outside_arena_bytes() const
+{
+    return history.capacity() * sizeof(VizFrame) + message_args.capacity() * sizeof(VizArg) + strings.bytes() + memory.op_values();
+}
+
+V_CPP_INLINE void VizEngine::note_memory()
+{
+    size_t footprint = arena.reserved() + outside_arena_bytes();
+    if (footprint > memory.peak)
+    {
+        memory.peak = footprint;
+        memory.peak_frame = frame_count();
+    }
+}
+
+V_CPP_INLINE void VizEngine::flush_chunk()
+{
+    string out;
+    if (chunk_format == HistoryFormat::Binary)
+    {
+        stream_binary_writer.write_header(history.size(), out);
+        for (const auto &frame : history)
+        {
+            stream_binary_writer.write(frame, out);
+        }
+    }
+    else
+    {
+        out = "[";
+        for (size_t i = 0; i < history.size(); ++i)
+        {
+            if (i > 0)
+                out += ',';
+            stream_writer.write(history[i], out);
+        }
+        out += ']';
+    }
+    flushed_frames += history.size();
+    history.clear();
+    message_args.clear();
+    frame_object_bytes = 0;
+    chunk_sink(out);
+}
+
+// --- Profiling report ---
+V_CPP_INLINE string VizProfile::report() const
+{
+    json out_objects = json::object();
+    for (const auto &[name, object] : objects)
+    {
+        json entry = {{"type", object.type},
+                      {"reads", object.reads},
+                      {"writes", object.writes},
+                      {"compares", object.compares},
+                      {"inserts", object.inserts},
+                      {"erases", object.erases}};
+        if (object.sequence)
+        {
+            entry["size"] = object.max_size;
+            entry["buckets"] = object.buckets;
+        }
+        out_objects[name] = std::move(entry);
+    }
+    json out = {{"frames", frames}, {"objects", std::move(out_objects)}};
+    if (!error.empty())
+        out["error"] = error;
+    return out.dump();
+}
+
+#endif // V_CPP_ENGINE_HPP
@@ -0,0 +1,203 @@
+#ifndef V_CPP_PARSER_HPP
+#define V_CPP_PARSER_HPP
+
+// ########## Parser: the universal input format ##########
+// Turns the text typed into the input box into the values VCtx hands out.
+// Part of the engine's implementation: included by v-cpp.hpp in the header-only build, compiled
+// into v-cpp.o by v-cpp.cpp in the prebuilt one (see the README).
+
+#include "../v-cpp.hpp"
+#include "../include/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// The InputParser is a self-contained class that turns a string like "arr={1,2}, k=5"
+// into a C++ map that we can easily access.
+class InputParser
+{
+private:
+    string text;
+    size_t pos = 0;
+
+    void skip_whitespace()
+    {
+        while (pos < text.length() && isspace(text[pos]))
+        {
+            pos++;
+        }
+    }
+
+    // Parses a variable name like 'arr', 'k', 'my_matrix'
+    string parse_key()
+    {
+        skip_whitespace();
+        size_t start = pos;
+        if (pos < text.length() && isalpha(text[pos]))
+        {
+            pos++;
+            while (pos < text.length() && (isalnum(text[pos]) || text[pos] == '_'))
+            {
+                pos++;
+            }
+        }
+        return text.substr(start, pos - start);
+    }
+
+    // The main function that decides what kind of value to parse next
+    json parse_value()
+    {
+        skip_whitespace();
+        if (pos >= text.length())
+            throw runtime_error("Unexpected end of input, expected a value.");
+
+        char current = text[pos];
+        if (current == '{')
+        {
+            pos++; // Consume '{'
+            return parse_array_or_matrix();
+        }
+        if (current == '"')
+        {
+            pos++; // Consume '"'
+            return parse_string();
+        }
+        if (isdigit(current) || current == '-')
+        {
+            return parse_number();
+        }
+        if (isalpha(current))
+        {
+            string literal = parse_key();
+            if (literal == "true")
+                return true;
+            if (literal == "false")
+                return false;
+            throw runtime_error("Invalid value token: " + literal);
+        }
+
+        throw runtime_error("Invalid character in value: " + string(1, current));
+    }
+
+    // Parses a string value, e.g., "Hello World"
+    json parse_string()
+    {
+        size_t start = pos;
+        while (pos < text.length() && text[pos] != '"')
+        {
+            pos++;
+        }
+        if (pos >= text.length())
+            throw runtime_error("Unterminated string literal.");
+        string val = text.substr(start, pos - start);
+        pos++; // Consume closing '"'
+        return val;
+    }
+
+    // Parses a number, can be integer or floating point
+    json parse_number()
+    {
+        size_t start = pos;
+        if (text[pos] == '-')
+            pos++;
+        while (pos < text.length() && isdigit(text[pos]))
+            pos++;
+        if (pos < text.length() && text[pos] == '.')
+        {
+            pos++;
+            while (pos < text.length() && isdigit(text[pos]))
+                pos++;
+            return stod(text.substr(start, pos - start));
+        }
+        return stoll(text.substr(start, pos - start)); // Use stoll for long long
+    }
+
+    // Parses an array like {1,2,3} or a matrix like {{1,2},{3,4}}
+    json parse_array_or_matrix()
+    {
+        skip_whitespace();
+        if (text[pos] == '}')
+        { // Empty array {}
+            pos++;
+            return json::array();
+        }
+
+        json arr = json::array();
+        while (pos < text.length())
+        {
+            arr.push_back(parse_value());
+            skip_whitespace();
+            if (text[pos] == '}')
+            {
+                pos++; // End of array
+                return arr;
+            }
+            if (text[pos] == ',')
+            {
+                pos++; // Continue to next element
+                continue;
+            }
+            throw runtime_error("Expected ',' or '}' in array declaration.");
+        }
+        throw runtime_error("Unterminated array declaration.");
+    }
+
+public:
+    // The only public function. Takes the raw string and returns the parsed map.
+    map<string, json> parse(const string &input)
+    {
+        text = input;
+        pos = 0;
+        map<string, json> result;
+
+        while (pos < text.length())
+        {
+            string name = parse_key();
+            if (name.empty())
+            {
+                skip_whitespace();
+                if (pos < text.length())
+                    throw runtime_error("Unexpected token at start of input.");
+                break;
+            }
+
+            skip_whitespace();
+            if (pos >= text.length() || text[pos] != '=')
+            {
+                throw runtime_error("Expected '=' after key '" + name + "'.");
+            }
+            pos++; // Consume '='
+
+            result[name] = parse_value();
+            skip_whitespace();
+            if (pos < text.length() && text[pos] == ',')
+            {
+                pos++;
+            }
+        }
+        return result;
+    }
+};
+
+// --- What VCtx holds: every input value by name ---
+struct VizInput
+{
+    map<string, json> values;
+};
+
+V_CPP_INLINE VCtx::VCtx(const string &raw_input)
+    : p_input(make_shared<const VizInput>(VizInput{InputParser().parse(raw_input)}))
+{
+}
+
+V_CPP_INLINE bool VCtx::has_input(const string &name) const
+{
+    return p_input->values.count(name) > 0;
+}
+
+template <typename T>
+T VCtx::input(const string &name) const
+{
+    return p_input->values.at(name).get<T>();
+}
+
+#endif // V_CPP_PARSER_HPP
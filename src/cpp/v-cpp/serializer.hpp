@@ -0,0 +1,1050 @@
+#ifndef V_CPP_SERIALIZER_HPP
+#define V_CPP_SERIALIZER_HPP
+
+// ########## Serializer: the JSON and VCPB exports ##########
+// Rebuilds the frames from the keyframes and deltas, and writes them out.
+// Part of the engine's implementation: included by v-cpp.hpp in the header-only build, compiled
+// into v-cpp.o by v-cpp.cpp in the prebuilt one (see the README).
+
+#include "../v-cpp.hpp"
+#include "../include/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// --- Number formatting for the JSON export ---
+// Integers go through to_chars. Doubles get the shortest digits that read back to the same value
+// (to_chars again), laid out the way json::dump() lays them out: "1.5", "100.0", "0.001", "1e+20".
+// Every function writes into a caller-provided buffer of at least max_chars bytes.
+struct VizNumberFormat
+{
+    static constexpr size_t max_chars = 32;
+
+    static char *write(char *p, int64_t v) { return to_chars(p, p + max_chars, v).ptr; }
+    static char *write(char *p, uint64_t v) { return to_chars(p, p + max_chars, v).ptr; }
+
+    static char *write(char *p, double v)
+    {
+        if (!isfinite(v))
+        {
+            memcpy(p, "null", 4);
+            return p + 4;
+        }
+        if (signbit(v))
+        {
+            *p++ = '-';
+            v = -v;
+        }
+        if (v == 0)
+        {
+            memcpy(p, "0.0", 3);
+            return p + 3;
+        }
+
+        // "d.ddde+xx": the shortest digits and where the decimal point goes
+        char sci[max_chars];
+        char *end = to_chars(sci, sci + sizeof sci, v, chars_format::scientific).ptr;
+        char *e = find(sci, end, 'e');
+        char digits[20];
+        int len = 0;
+        digits[len++] = sci[0];
+        for (char *q = sci + 2; q < e; ++q)
+            digits[len++] = *q;
+        int exponent = 0;
+        from_chars(e + (e[1] == '+' ? 2 : 1), end, exponent);
+        int point = exponent + 1; // Digits before the decimal point
+
+        constexpr int min_point = -4, max_point = numeric_limits<double>::digits10;
+        if (len <= point && point <= max_point)
+        {
+            // digits[000].0
+            memcpy(p, digits, len);
+            memset(p + len, '0', point - len);
+            p += point;
+            memcpy(p, ".0", 2);
+            return p + 2;
+        }
+        if (0 < point && point <= max_point)
+        {
+            // dig.its
+            memcpy(p, digits, point);
+            p[point] = '.';
+            memcpy(p + point + 1, digits + point, len - point);
+            return p + len + 1;
+        }
+        if (min_point < point && point <= 0)
+        {
+            // 0.[000]digits
+            memcpy(p, "0.", 2);
+            memset(p + 2, '0', -point);
+            memcpy(p + 2 - point, digits, len);
+            return p + 2 - point + len;
+        }
+        // d[.igits]e+xx, with at least two exponent digits
+        *p++ = digits[0];
+        if (len > 1)
+        {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        int magnitude = exponent < 0 ? -exponent : exponent;
+        if (magnitude < 10)
+            *p++ = '0';
+        return to_chars(p, p + 4, magnitude).ptr;
+    }
+
+    template <typename Number>
+    static void append(Number v, string &out)
+    {
+        char buffer[max_chars];
+        out.append(buffer, write(buffer, v));
+    }
+};
+
+// --- Reading the binary value encoding back ---
+// Used on export to turn serialized data into JSON text and to replay ops on it,
+// so the engine never needs a json tree for the recorded data.
+struct VizValueReader
+{
+    using Tag = VizByteWriter::Tag;
+
+    static uint64_t varint(const char *&p)
+    {
+        uint64_t result = 0;
+        int shift = 0;
+        uint8_t b;
+        do
+        {
+            b = static_cast<uint8_t>(*p++);
+            result |= static_cast<uint64_t>(b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        return result;
+    }
+
+    static int64_t zigzag(const char *&p)
+    {
+        uint64_t v = varint(p);
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    static double f64(const char *&p)
+    {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i)
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+        p += 8;
+        double v;
+        memcpy(&v, &bits, sizeof v);
+        return v;
+    }
+
+    static string_view str(const char *&p)
+    {
+        size_t length = varint(p);
+        string_view s(p, length);
+        p += length;
+        return s;
+    }
+
+    // Moves `p` past one value
+    static void skip(const char *&p)
+    {
+        switch (static_cast<uint8_t>(*p++))
+        {
+        case Tag::Int:
+        case Tag::UInt:
+            varint(p);
+            break;
+        case Tag::Double:
+            p += 8;
+            break;
+        case Tag::String:
+            str(p);
+            break;
+        case Tag::Array:
+            for (size_t n = varint(p); n > 0; --n)
+                skip(p);
+            break;
+        case Tag::Object:
+            for (size_t n = varint(p); n > 0; --n)
+            {
+                str(p);
+                skip(p);
+            }
+            break;
+        case Tag::IntArray:
+            for (size_t n = varint(p); n > 0; --n)
+                varint(p);
+            break;
+        case Tag::DoubleArray:
+            p += 8 * varint(p);
+            break;
+        case Tag::Matrix:
+            varint(p);
+            varint(p);
+            skip(p);
+            break;
+        case Tag::Map:
+            skip(p);
+            skip(p);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Bytes in front of the element array: the shape of a matrix, nothing for a plain array
+    static size_t shape_size(string_view value)
+    {
+        const char *p = value.data();
+        if (static_cast<uint8_t>(*p++) != Tag::Matrix)
+            return 0;
+        varint(p);
+        varint(p);
+        return p - value.data();
+    }
+
+    // The elements of an array value, each as a standalone value (packed elements get their tag back).
+    // A map gives its entries, each as a [key, value] array.
+    static vector<string> split(string_view array)
+    {
+        const char *p = array.data();
+        uint8_t tag = static_cast<uint8_t>(*p++);
+        if (tag == Tag::Map)
+        {
+            const char *values = p;
+            skip(values);
+            uint8_t key_tag = static_cast<uint8_t>(*p++), value_tag = static_cast<uint8_t>(*values++);
+            vector<string> entries(varint(p));
+            varint(values);
+            string key_scratch, value_scratch;
+            for (auto &entry : entries)
+            {
+                const char *key = p, *value = values;
+                const char *key_start = element(p, key_tag, key_scratch), *value_start = element(values, value_tag, value_scratch);
+                VizByteWriter w{entry};
+                w.byte(Tag::Array);
+                w.varint(2);
+                entry.append(key_start, key_tag == Tag::Array ? p - key : key_scratch.size());
+                entry.append(value_start, value_tag == Tag::Array ? values - value : value_scratch.size());
+            }
+            return entries;
+        }
+        vector<string> items(varint(p));
+        for (auto &item : items)
+        {
+            const char *start = p;
+            if (tag == Tag::IntArray || tag == Tag::DoubleArray)
+            {
+                item += static_cast<char>(tag == Tag::IntArray ? Tag::Int : Tag::Double);
+                tag == Tag::IntArray ? (void)varint(p) : (void)(p += 8);
+            }
+            else
+            {
+                skip(p);
+            }
+            item.append(start, p);
+        }
+        return items;
+    }
+
+    // The inverse of split(): an array of `items`, packed again when they are all integers or all doubles
+    template <typename Items>
+    static void join(const Items &items, string &out)
+    {
+        auto all_tagged = [&](uint8_t tag)
+        { return !items.empty() && all_of(items.begin(), items.end(), [&](string_view item) { return static_cast<uint8_t>(item[0]) == tag; }); };
+        uint8_t tag = all_tagged(Tag::Int) ? Tag::IntArray : (all_tagged(Tag::Double) ? Tag::DoubleArray : Tag::Array);
+        VizByteWriter w{out};
+        w.byte(tag);
+        w.varint(items.size());
+        for (string_view item : items)
+        {
+            out += item.substr(tag == Tag::Array ? 0 : 1);
+        }
+    }
+
+    // The inverse of split() for a map: [key, value] entries back into a keys and a values column
+    static void join_entries(const vector<string> &entries, string &out)
+    {
+        vector<string_view> keys, values;
+        keys.reserve(entries.size());
+        values.reserve(entries.size());
+        for (const auto &entry : entries)
+        {
+            keys.push_back(entry_key(entry));
+            values.push_back(entry_value(entry));
+        }
+        out += static_cast<char>(Tag::Map);
+        join(keys, out);
+        join(values, out);
+    }
+
+    // The parts of a [key, value] map entry
+    static string_view entry_key(string_view entry)
+    {
+        const char *p = entry.data() + 1;
+        varint(p); // Entry size
+        const char *start = p;
+        skip(p);
+        return {start, static_cast<size_t>(p - start)};
+    }
+
+    static string_view entry_value(string_view entry)
+    {
+        string_view key = entry_key(entry);
+        return entry.substr(key.data() + key.size() - entry.data());
+    }
+
+    // Orders two values the way json values compare: numbers by value, strings by bytes,
+    // arrays and objects element by element. Advances both pointers past their value.
+    static int compare(const char *&a, const char *&b)
+    {
+        uint8_t ta = static_cast<uint8_t>(*a), tb = static_cast<uint8_t>(*b);
+        if (is_number(ta) && is_number(tb))
+        {
+            return compare_numbers(a, b);
+        }
+        if (is_array(ta) && is_array(tb))
+        {
+            ++a, ++b;
+            size_t na = varint(a), nb = varint(b);
+            int result = 0;
+            string ea, eb;
+            size_t n = 0;
+            for (; n < min(na, nb); ++n)
+            {
+                const char *pa = element(a, ta, ea), *pb = element(b, tb, eb);
+                if (result == 0)
+                    result = compare(pa, pb);
+            }
+            for (; n < na; ++n)
+                element(a, ta, ea);
+            for (size_t m = n; m < nb; ++m)
+                element(b, tb, eb);
+            return result != 0 ? result : (na < nb ? -1 : (na > nb ? 1 : 0));
+        }
+        if (ta != tb)
+        {
+            int result = ta < tb ? -1 : 1;
+            skip(a), skip(b);
+            return result;
+        }
+        ++a, ++b;
+        switch (ta)
+        {
+        case Tag::String:
+        {
+            int result = str(a).compare(str(b));
+            return result < 0 ? -1 : (result > 0 ? 1 : 0);
+        }
+        case Tag::Object:
+        {
+            size_t na = varint(a), nb = varint(b);
+            int result = 0;
+            size_t n = 0;
+            for (; n < min(na, nb); ++n)
+            {
+                if (result == 0)
+                {
+                    int keys = str(a).compare(str(b));
+                    result = keys < 0 ? -1 : (keys > 0 ? 1 : compare(a, b));
+                }
+                else
+                {
+                    str(a), skip(a), str(b), skip(b);
+                }
+            }
+            for (size_t m = n; m < na; ++m)
+                str(a), skip(a);
+            for (size_t m = n; m < nb; ++m)
+                str(b), skip(b);
+            return result != 0 ? result : (na < nb ? -1 : (na > nb ? 1 : 0));
+        }
+        case Tag::Map:
+        {
+            // Like the {"keys", "values"} objects they are exported as
+            int keys = compare(a, b);
+            int values = compare(a, b);
+            return keys != 0 ? keys : values;
+        }
+        case Tag::Matrix:
+        {
+            uint64_t ra = varint(a), ca = varint(a), rb = varint(b), cb = varint(b);
+            int result = compare(a, b);
+            if (ra != rb || ca != cb)
+                result = ra != rb ? (ra < rb ? -1 : 1) : (ca < cb ? -1 : 1);
+            return result;
+        }
+        default:
+            return 0; // null, false, true
+        }
+    }
+
+    static int compare(string_view a, string_view b)
+    {
+        const char *pa = a.data(), *pb = b.data();
+        return compare(pa, pb);
+    }
+
+    // Writes one value as JSON text, formatted exactly like json::dump()
+    static void to_json(const char *&p, string &out)
+    {
+        uint8_t tag = static_cast<uint8_t>(*p++);
+        switch (tag)
+        {
+        case Tag::False:
+            out += "false";
+            break;
+        case Tag::True:
+            out += "true";
+            break;
+        case Tag::Int:
+            VizNumberFormat::append(zigzag(p), out);
+            break;
+        case Tag::UInt:
+            VizNumberFormat::append(varint(p), out);
+            break;
+        case Tag::Double:
+            VizNumberFormat::append(f64(p), out);
+            break;
+        case Tag::String:
+            append_string(str(p), out);
+            break;
+        case Tag::Array:
+        {
+            out += '[';
+            for (size_t n = varint(p), i = 0; i < n; ++i)
+            {
+                if (i > 0)
+                    out += ',';
+                to_json(p, out);
+            }
+            out += ']';
+            break;
+        }
+        case Tag::IntArray:
+        case Tag::DoubleArray:
+            out += '[';
+            append_packed(p, tag, varint(p), out);
+            out += ']';
+            break;
+        case Tag::Object:
+        {
+            out += '{';
+            for (size_t n = varint(p), i = 0; i < n; ++i)
+            {
+                if (i > 0)
+                    out += ',';
+                append_string(str(p), out);
+                out += ':';
+                to_json(p, out);
+            }
+            out += '}';
+            break;
+        }
+        case Tag::Matrix:
+            shape_to_json(--p, out);
+            to_json(p, out);
+            out += '}';
+            break;
+        case Tag::Map:
+            out += "{\"keys\":";
+            to_json(p, out);
+            out += ",\"values\":";
+            to_json(p, out);
+            out += '}';
+            break;
+        default:
+            out += "null";
+            break;
+        }
+    }
+
+    // A map's [key, value] entries as its {"keys", "values"} JSON text
+    static void entries_to_json(const vector<string> &entries, string &out)
+    {
+        out += "{\"keys\":[";
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i > 0)
+                out += ',';
+            to_json(entry_key(entries[i]), out);
+        }
+        out += "],\"values\":[";
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i > 0)
+                out += ',';
+            to_json(entry_value(entries[i]), out);
+        }
+        out += "]}";
+    }
+
+    // The start of a matrix's JSON text, up to where its cells array goes (the caller closes it with '}')
+    static void shape_to_json(const char *&p, string &out)
+    {
+        ++p; // Tag::Matrix
+        out += "{\"rows\":";
+        VizNumberFormat::append(varint(p), out);
+        out += ",\"cols\":";
+        VizNumberFormat::append(varint(p), out);
+        out += ",\"cells\":";
+    }
+
+    static void to_json(string_view value, string &out)
+    {
+        const char *p = value.data();
+        to_json(p, out);
+    }
+
+    // The `count` numbers of a packed array, comma separated. They are handled in batches: the
+    // varints are decoded into a plain array first, then formatted back to back into a stack
+    // buffer that is appended in one go, so the output string grows once per batch.
+    static void append_packed(const char *&p, uint8_t tag, size_t count, string &out)
+    {
+        constexpr size_t batch = 256;
+        union
+        {
+            int64_t ints[batch];
+            double doubles[batch];
+        };
+        char text[batch * (VizNumberFormat::max_chars + 1)];
+        for (size_t done = 0; done < count;)
+        {
+            size_t n = min(batch, count - done);
+            char *w = text;
+            if (tag == Tag::IntArray)
+            {
+                for (size_t i = 0; i < n; ++i)
+                    ints[i] = zigzag(p);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    *w = ',';
+                    w = VizNumberFormat::write(w + (done + i > 0), ints[i]);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < n; ++i)
+                    doubles[i] = f64(p);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    *w = ',';
+                    w = VizNumberFormat::write(w + (done + i > 0), doubles[i]);
+                }
+            }
+            out.append(text, w);
+            done += n;
+        }
+    }
+
+    static void append_string(string_view s, string &out)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : s)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0xf];
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+
+private:
+    static bool is_number(uint8_t tag) { return tag == Tag::Int || tag == Tag::UInt || tag == Tag::Double; }
+    static bool is_array(uint8_t tag) { return tag == Tag::Array || tag == Tag::IntArray || tag == Tag::DoubleArray; }
+
+    // The next element of an array with tag `tag`, as a standalone value (kept in `scratch` when packed)
+    static const char *element(const char *&p, uint8_t tag, string &scratch)
+    {
+        const char *start = p;
+        if (tag == Tag::Array)
+        {
+            skip(p);
+            return start;
+        }
+        scratch.assign(1, static_cast<char>(tag == Tag::IntArray ? Tag::Int : Tag::Double));
+        tag == Tag::IntArray ? (void)varint(p) : (void)(p += 8);
+        scratch.append(start, p);
+        return scratch.data();
+    }
+
+    static int compare_numbers(const char *&a, const char *&b)
+    {
+        uint8_t ta = static_cast<uint8_t>(*a++), tb = static_cast<uint8_t>(*b++);
+        if (ta == Tag::Double || tb == Tag::Double)
+        {
+            double x = ta == Tag::Double ? f64(a) : (ta == Tag::Int ? static_cast<double>(zigzag(a)) : static_cast<double>(varint(a)));
+            double y = tb == Tag::Double ? f64(b) : (tb == Tag::Int ? static_cast<double>(zigzag(b)) : static_cast<double>(varint(b)));
+            return x < y ? -1 : (y < x ? 1 : 0);
+        }
+        if (ta == tb)
+        {
+            if (ta == Tag::Int)
+            {
+                int64_t x = zigzag(a), y = zigzag(b);
+                return x < y ? -1 : (y < x ? 1 : 0);
+            }
+            uint64_t x = varint(a), y = varint(b);
+            return x < y ? -1 : (y < x ? 1 : 0);
+        }
+        // An Int is always below a UInt (UInt only holds values above the int64 range)
+        ta == Tag::Int ? (void)zigzag(a) : (void)varint(a);
+        tb == Tag::Int ? (void)zigzag(b) : (void)varint(b);
+        return ta == Tag::Int ? -1 : 1;
+    }
+};
+
+// --- Reconstruction and export ---
+V_CPP_INLINE map<string, VizSnapshotPtr> VizEngine::objects_at(size_t index) const
+{
+    size_t start = index;
+    while (start > 0 && !history[start].keyframe)
+    {
+        start--;
+    }
+
+    map<string, VizSnapshotPtr> objects;
+    for (size_t i = start; i <= index; ++i)
+    {
+        apply_frame(objects, history[i], strings);
+    }
+    return objects;
+}
+
+V_CPP_INLINE string VizEngine::frame_at(size_t index) const
+{
+    json objects = json::object();
+    for (const auto &[name, snapshot] : objects_at(index))
+    {
+        MaterializedObject object;
+        materialize(object, snapshot.get());
+        json highlights = json::object();
+        for (const auto &[key, state] : snapshot->highlights)
+        {
+            highlights[strings[key]] = strings[state];
+        }
+        objects[name] = {{"type", strings[snapshot->type]}, {"data", json::parse(object.json_text())}, {"highlights", highlights}};
+    }
+    json frame = {{"message", message_text(history[index])}, {"objects", objects}};
+    if (history[index].dropped > 0)
+    {
+        frame["dropped"] = history[index].dropped;
+    }
+    return frame.dump();
+}
+
+V_CPP_INLINE string VizEngine::dump_history() const
+{
+    string out;
+    dump_history(out);
+    return out;
+}
+
+V_CPP_INLINE void VizEngine::dump_history(string &out) const
+{
+    HistoryWriter writer(*this);
+    out += '[';
+    for (size_t i = 0; i < history.size(); ++i)
+    {
+        if (i > 0)
+            out += ',';
+        writer.write(history[i], out);
+    }
+    out += ']';
+}
+
+V_CPP_INLINE string VizEngine::dump_history_binary() const
+{
+    BinaryHistoryWriter writer(*this);
+    string out;
+    writer.write_header(history.size(), out);
+    for (const auto &frame : history)
+    {
+        writer.write(frame, out);
+    }
+    return out;
+}
+
+V_CPP_INLINE string VizEngine::message_text(const VizFrame &frame) const
+{
+    const string &tmpl = strings[frame.message];
+    if (frame.arg_count == 0)
+        return tmpl;
+
+    string out;
+    size_t at = 0;
+    for (uint32_t a = 0; a < frame.arg_count; ++a)
+    {
+        size_t hole = tmpl.find("{}", at);
+        if (hole == string::npos)
+            break;
+        out.append(tmpl, at, hole - at);
+        const auto &arg = message_args[frame.first_arg + a];
+        switch (arg.kind)
+        {
+        case VizArg::Int:
+            out += to_string(arg.i);
+            break;
+        case VizArg::Unsigned:
+            out += to_string(arg.u);
+            break;
+        case VizArg::Double:
+            out += to_string(arg.d);
+            break;
+        case VizArg::String:
+            out += strings[arg.s];
+            break;
+        }
+        at = hole + 2;
+    }
+    out.append(tmpl, at, string::npos);
+    return out;
+}
+
+V_CPP_INLINE void VizEngine::MaterializedObject::split_items()
+{
+    if (!split)
+    {
+        size_t shape_size = VizValueReader::shape_size(data);
+        shape.assign(data, 0, shape_size);
+        items = VizValueReader::split(string_view(data).substr(shape_size));
+        entries = static_cast<uint8_t>(data[0]) == VizByteWriter::Map;
+        split = true;
+    }
+}
+
+V_CPP_INLINE void VizEngine::MaterializedObject::encode(string &out) const
+{
+    if (split && entries)
+    {
+        VizValueReader::join_entries(items, out);
+    }
+    else if (split)
+    {
+        out += shape;
+        VizValueReader::join(items, out);
+    }
+    else
+    {
+        out += data;
+    }
+}
+
+V_CPP_INLINE const string &VizEngine::MaterializedObject::json_text()
+{
+    if (text.empty())
+    {
+        if (split && entries)
+        {
+            VizValueReader::entries_to_json(items, text);
+        }
+        else if (split)
+        {
+            const char *p = shape.data();
+            if (!shape.empty())
+                VizValueReader::shape_to_json(p, text);
+            text += '[';
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                if (i > 0)
+                    text += ',';
+                VizValueReader::to_json(items[i], text);
+            }
+            text += ']';
+            if (!shape.empty())
+                text += '}';
+        }
+        else
+        {
+            VizValueReader::to_json(data, text);
+        }
+    }
+    return text;
+}
+
+V_CPP_INLINE void VizEngine::HistoryWriter::write(const VizFrame &frame, string &out)
+{
+    const auto &table = engine->strings;
+    apply_frame(objects, frame, table);
+    out += '{';
+    if (frame.dropped > 0)
+    {
+        out += "\"dropped\":";
+        out += to_string(frame.dropped);
+        out += ',';
+    }
+    out += "\"message\":";
+    out += json(engine->message_text(frame)).dump();
+    out += ",\"objects\":{";
+    bool first = true;
+    for (const auto &[name, snapshot] : objects)
+    {
+        auto &object = materialized[name];
+        materialize(object, snapshot.get());
+        if (!first)
+            out += ',';
+        first = false;
+        out += json(name).dump();
+        out += ":{\"data\":";
+        out += object.json_text();
+        out += ",\"highlights\":{";
+        for (size_t h = 0; h < snapshot->highlights.size(); ++h)
+        {
+            if (h > 0)
+                out += ',';
+            out += json(table[snapshot->highlights[h].first]).dump();
+            out += ':';
+            out += json(table[snapshot->highlights[h].second]).dump();
+        }
+        out += "},\"type\":";
+        out += json(table[snapshot->type]).dump();
+        out += '}';
+    }
+    out += "}}";
+}
+
+V_CPP_INLINE void VizEngine::BinaryHistoryWriter::write_header(size_t frame_count, string &out)
+{
+    const auto &strings = engine->strings;
+    VizByteWriter w{out};
+    out += "VCPB";
+    w.byte(6); // Format version
+    w.varint(strings.size() - sent_strings);
+    for (; sent_strings < strings.size(); ++sent_strings)
+    {
+        w.str(strings[sent_strings]);
+    }
+    w.varint(frame_count);
+}
+
+V_CPP_INLINE void VizEngine::BinaryHistoryWriter::write(const VizFrame &frame, string &out)
+{
+    VizByteWriter w{out};
+    w.varint(frame.dropped);
+    w.varint(frame.message);
+    w.varint(frame.arg_count);
+    for (uint32_t a = 0; a < frame.arg_count; ++a)
+    {
+        const auto &arg = engine->message_args[frame.first_arg + a];
+        w.byte(arg.kind);
+        switch (arg.kind)
+        {
+        case VizArg::Int:
+            w.zigzag(arg.i);
+            break;
+        case VizArg::Unsigned:
+            w.varint(arg.u);
+            break;
+        case VizArg::Double:
+            w.f64(arg.d);
+            break;
+        case VizArg::String:
+            w.varint(arg.s);
+            break;
+        }
+    }
+
+    string records;
+    VizByteWriter r{records};
+    size_t record_count = 0;
+    vector<VizEdit> edits;
+    for (const auto &snapshot : frame.objects)
+    {
+        auto &object = materialized[snapshot->name];
+        if (object.applied == snapshot.get())
+            continue; // Unchanged object repeated by a keyframe
+
+        edits.clear();
+        bool replaced = materialize(object, snapshot.get(), &edits);
+        record_count++;
+        r.varint(snapshot->name);
+        r.byte(replaced ? 0 : 1);
+        r.varint(snapshot->type);
+        r.varint(snapshot->highlights.size());
+        for (const auto &[key, state] : snapshot->highlights)
+        {
+            r.varint(key);
+            r.varint(state);
+        }
+        if (replaced)
+        {
+            object.encode(records);
+            continue;
+        }
+        r.varint(edits.size());
+        for (const auto &edit : edits)
+        {
+            r.byte(static_cast<uint8_t>(edit.kind));
+            if (edit.kind == VizEditKind::Clear)
+                continue;
+            r.varint(edit.index);
+            if (edit.kind != VizEditKind::Erase)
+                records += edit.value;
+        }
+    }
+    w.varint(record_count);
+    out += records;
+}
+
+V_CPP_INLINE bool VizEngine::materialize(MaterializedObject &object, const VizSnapshot *target, vector<VizEdit> *edits)
+{
+    vector<const VizSnapshot *> chain;
+    const VizSnapshot *at = target;
+    while (at != object.applied && !at->full)
+    {
+        chain.push_back(at);
+        at = at->base.get();
+    }
+    bool replaced = at != object.applied;
+    if (replaced)
+    {
+        object.data.assign(at->data);
+        object.shape.clear();
+        object.items.clear();
+        object.split = false;
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        for (const auto &op : (*it)->ops)
+        {
+            object.split_items();
+            apply_op(object.items, op, replaced ? nullptr : edits);
+        }
+    }
+    if (object.applied != target)
+    {
+        object.text.clear();
+    }
+    object.applied = target;
+    return replaced;
+}
+
+V_CPP_INLINE void VizEngine::apply_op(vector<string> &data, const VizOp &op, vector<VizEdit> *edits)
+{
+    auto insert_at = [&](size_t index, const string &value)
+    {
+        data.insert(data.begin() + index, value);
+        if (edits)
+            edits->push_back({VizEditKind::Insert, index, value});
+    };
+    auto erase_at = [&](size_t index)
+    {
+        data.erase(data.begin() + index);
+        if (edits)
+            edits->push_back({VizEditKind::Erase, index});
+    };
+    auto set_at = [&](size_t index, const string &value)
+    {
+        data[index] = value;
+        if (edits)
+            edits->push_back({VizEditKind::Set, index, value});
+    };
+    auto key_of = [](const string &entry) { return VizValueReader::entry_key(entry); };
+
+    switch (op.kind)
+    {
+    case VizOpKind::PushBack:
+        insert_at(data.size(), op.value);
+        break;
+    case VizOpKind::PushFront:
+        insert_at(0, op.value);
+        break;
+    case VizOpKind::PopBack:
+        if (!data.empty())
+            erase_at(data.size() - 1);
+        break;
+    case VizOpKind::PopFront:
+        if (!data.empty())
+            erase_at(0);
+        break;
+    case VizOpKind::SetAt:
+        set_at(op.index, op.value);
+        break;
+    case VizOpKind::InsertSorted:
+    {
+        auto it = upper_bound(data.begin(), data.end(), op.value, [](const string &value, const string &item) { return VizValueReader::compare(value, item) < 0; });
+        insert_at(it - data.begin(), op.value);
+        break;
+    }
+    case VizOpKind::EraseValue:
+    {
+        auto it = find(data.begin(), data.end(), op.value);
+        if (it != data.end())
+            erase_at(it - data.begin());
+        break;
+    }
+    case VizOpKind::SetKey:
+    {
+        auto it = find_if(data.begin(), data.end(), [&](const string &entry) { return key_of(entry) == op.key; });
+        if (it != data.end())
+        {
+            set_at(it - data.begin(), op.value);
+            break;
+        }
+        [[fallthrough]];
+    }
+    case VizOpKind::InsertKey:
+    {
+        auto it = find_if(data.begin(), data.end(), [&](const string &entry) { return VizValueReader::compare(op.key, key_of(entry)) < 0; });
+        insert_at(it - data.begin(), op.value);
+        break;
+    }
+    case VizOpKind::Clear:
+        data.clear();
+        if (edits)
+            edits->push_back({VizEditKind::Clear});
+        break;
+    }
+}
+
+V_CPP_INLINE void VizEngine::apply_frame(map<string, VizSnapshotPtr> &objects, const VizFrame &frame, const VizStringTable &strings)
+{
+    if (frame.keyframe)
+    {
+        objects.clear();
+    }
+    for (const auto &snapshot : frame.objects)
+    {
+        objects[strings[snapshot->name]] = snapshot;
+    }
+}
+
+#endif // V_CPP_SERIALIZER_HPP
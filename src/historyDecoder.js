@@ -0,0 +1,306 @@
+// Decoder for the compact "VCPB" history format written by VizEngine (see v-cpp.hpp).
+// It rebuilds exactly what JSON.parse gives for the JSON export:
+//   [{ message, dropped?, objects: { name: { data, highlights, type } } }]
+// Objects that did not change between two frames are shared between them instead of copied.
+
+const textDecoder = new TextDecoder();
+
+// Value tags, in the order of VizByteWriter::Tag
+const TAG_NULL = 0;
+const TAG_FALSE = 1;
+const TAG_TRUE = 2;
+const TAG_INT = 3;
+const TAG_DOUBLE = 4;
+const TAG_STRING = 5;
+const TAG_ARRAY = 6;
+const TAG_OBJECT = 7;
+const TAG_INT_ARRAY = 8;
+const TAG_DOUBLE_ARRAY = 9;
+const TAG_UINT = 10;
+const TAG_MATRIX = 11;
+const TAG_MAP = 12;
+
+// Edit kinds, in the order of VizEditKind
+const EDIT_INSERT = 0;
+const EDIT_ERASE = 1;
+const EDIT_SET = 2;
+const EDIT_CLEAR = 3;
+
+const RECORD_FULL = 0;
+
+// Message argument kinds, in the order of VizArg::Kind
+const ARG_INT = 0;
+const ARG_UNSIGNED = 1;
+const ARG_DOUBLE = 2;
+const ARG_STRING = 3;
+
+class ByteReader {
+  constructor(bytes) {
+    this.bytes = bytes;
+    this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    this.pos = 0;
+  }
+
+  byte() {
+    return this.bytes[this.pos++];
+  }
+
+  varint() {
+    // Plain arithmetic instead of bit operations, so values above 2^31 survive (up to 2^53, like JSON.parse)
+    let result = 0;
+    let scale = 1;
+    let b;
+    do {
+      b = this.bytes[this.pos++];
+      result += (b & 0x7f) * scale;
+      scale *= 128;
+    } while (b & 0x80);
+    return result;
+  }
+
+  // Exact at any size, for integers that are printed rather than used as numbers
+  bigVarint() {
+    let result = 0n;
+    let shift = 0n;
+    let b;
+    do {
+      b = this.bytes[this.pos++];
+      result |= BigInt(b & 0x7f) << shift;
+      shift += 7n;
+    } while (b & 0x80);
+    return result;
+  }
+
+  zigzag() {
+    const start = this.pos;
+    const v = this.varint();
+    if (v > Number.MAX_SAFE_INTEGER) {
+      // The sign is in the lowest bit, which a double may have rounded away
+      this.pos = start;
+      const b = this.bigVarint();
+      return Number(b & 1n ? -((b + 1n) >> 1n) : b >> 1n);
+    }
+    return v % 2 === 0 ? v / 2 : -(v + 1) / 2;
+  }
+
+  f64() {
+    const v = this.view.getFloat64(this.pos, true);
+    this.pos += 8;
+    return v;
+  }
+
+  str() {
+    const length = this.varint();
+    const s = textDecoder.decode(this.bytes.subarray(this.pos, this.pos + length));
+    this.pos += length;
+    return s;
+  }
+
+  value() {
+    const tag = this.byte();
+    switch (tag) {
+      case TAG_NULL: return null;
+      case TAG_FALSE: return false;
+      case TAG_TRUE: return true;
+      case TAG_INT: return this.zigzag();
+      case TAG_UINT: return this.varint();
+      case TAG_DOUBLE: return this.f64();
+      case TAG_STRING: return this.str();
+      case TAG_ARRAY: {
+        const items = new Array(this.varint());
+        for (let i = 0; i < items.length; i++) items[i] = this.value();
+        return items;
+      }
+      case TAG_OBJECT: {
+        const object = {};
+        for (let n = this.varint(); n > 0; n--) {
+          const key = this.str();
+          object[key] = this.value();
+        }
+        return object;
+      }
+      case TAG_INT_ARRAY: {
+        const items = new Array(this.varint());
+        for (let i = 0; i < items.length; i++) items[i] = this.zigzag();
+        return items;
+      }
+      case TAG_DOUBLE_ARRAY: {
+        const items = new Array(this.varint());
+        for (let i = 0; i < items.length; i++) items[i] = this.f64();
+        return items;
+      }
+      case TAG_MATRIX: {
+        const rows = this.varint();
+        const cols = this.varint();
+        return { rows, cols, cells: this.value() };
+      }
+      case TAG_MAP: {
+        const keys = this.value();
+        return { keys, values: this.value() };
+      }
+      default:
+        throw new Error(`Unknown value tag ${tag} at byte ${this.pos - 1}`);
+    }
+  }
+}
+
+// A double the way C++ to_string (printf "%f") writes it
+function formatDouble(reader) {
+  const negative = (reader.bytes[reader.pos + 7] & 0x80) !== 0;
+  const v = reader.f64();
+  if (Number.isNaN(v)) return negative ? '-nan' : 'nan';
+  if (!Number.isFinite(v)) return negative ? '-inf' : 'inf';
+  if (Math.abs(v) >= 1e21) return `${BigInt(v)}.000000`; // toFixed switches to exponents here
+  return (negative ? '-' : '') + Math.abs(v).toFixed(6); // Keeps the sign of -0 and of values that round to 0
+}
+
+// Reads a message template and its arguments, and fills every "{}" the way the engine's
+// message_text does (integers exactly, doubles like C++ to_string, i.e. six decimals)
+function readMessage(reader, strings) {
+  const template = strings[reader.varint()];
+  const argCount = reader.varint();
+  if (argCount === 0) return template;
+
+  let text = '';
+  let at = 0;
+  for (let a = 0; a < argCount; a++) {
+    const kind = reader.byte();
+    let arg;
+    if (kind === ARG_INT) {
+      const v = reader.bigVarint();
+      arg = String(v & 1n ? -((v + 1n) >> 1n) : v >> 1n);
+    } else if (kind === ARG_UNSIGNED) arg = String(reader.bigVarint());
+    else if (kind === ARG_DOUBLE) arg = formatDouble(reader);
+    else if (kind === ARG_STRING) arg = strings[reader.varint()];
+    else throw new Error(`Unknown message argument kind ${kind}`);
+
+    const hole = template.indexOf('{}', at);
+    if (hole < 0) continue; // More arguments than holes, the rest are still read past
+    text += template.slice(at, hole) + arg;
+    at = hole + 2;
+  }
+  return text + template.slice(at);
+}
+
+// Applies an edit list to `previous` without touching it (older frames still point at it)
+function applyEdits(previous, reader) {
+  if (previous !== null && typeof previous === 'object' && !Array.isArray(previous)) {
+    if ('keys' in previous) return applyEntryEdits(previous, reader);
+    // A matrix: the edits address its flat, row-major cells
+    const cells = applyEdits(previous.cells, reader);
+    return cells === previous.cells ? previous : { ...previous, cells };
+  }
+  const count = reader.varint();
+  if (count === 0) return previous;
+
+  let data = previous.slice();
+  for (let i = 0; i < count; i++) {
+    const kind = reader.byte();
+    if (kind === EDIT_CLEAR) {
+      data = [];
+      continue;
+    }
+    const index = reader.varint();
+    if (kind === EDIT_INSERT) {
+      data.splice(index, 0, reader.value());
+    } else if (kind === EDIT_ERASE) {
+      data.splice(index, 1);
+    } else if (kind === EDIT_SET) {
+      data[index] = reader.value();
+    } else {
+      throw new Error(`Unknown edit kind ${kind}`);
+    }
+  }
+  return data;
+}
+
+// A map's edits address its entries, which come as [key, value] and land in both columns
+function applyEntryEdits(previous, reader) {
+  const count = reader.varint();
+  if (count === 0) return previous;
+
+  let keys = previous.keys.slice();
+  let values = previous.values.slice();
+  for (let i = 0; i < count; i++) {
+    const kind = reader.byte();
+    if (kind === EDIT_CLEAR) {
+      keys = [];
+      values = [];
+      continue;
+    }
+    const index = reader.varint();
+    if (kind === EDIT_INSERT) {
+      const [key, value] = reader.value();
+      keys.splice(index, 0, key);
+      values.splice(index, 0, value);
+    } else if (kind === EDIT_ERASE) {
+      keys.splice(index, 1);
+      values.splice(index, 1);
+    } else if (kind === EDIT_SET) {
+      [keys[index], values[index]] = reader.value();
+    } else {
+      throw new Error(`Unknown edit kind ${kind}`);
+    }
+  }
+  return { keys, values };
+}
+
+// The JSON export lists objects by name, keep the same order when a new object shows up
+function sortedByName(objects) {
+  const sorted = {};
+  for (const name of Object.keys(objects).sort()) sorted[name] = objects[name];
+  return sorted;
+}
+
+// Decodes a stream of chunks (visualizeMyLogicStreamingBinary) or a whole history
+// (visualizeMyLogicBinary). Chunks must be fed in order, the decoder carries state between them.
+export class HistoryDecoder {
+  constructor() {
+    this.objects = {};
+    this.strings = []; // Interned names, types, highlights and messages, grown by every chunk
+  }
+
+  decodeChunk(bytes) {
+    const reader = new ByteReader(bytes);
+    if (textDecoder.decode(bytes.subarray(0, 4)) !== 'VCPB') throw new Error('Not a VCPB history chunk');
+    reader.pos = 4;
+    const version = reader.byte();
+    if (version !== 6) throw new Error(`Unsupported VCPB version ${version}`);
+
+    const strings = this.strings;
+    for (let n = reader.varint(); n > 0; n--) strings.push(reader.str());
+
+    const frames = new Array(reader.varint());
+    for (let i = 0; i < frames.length; i++) {
+      const dropped = reader.varint();
+      const message = readMessage(reader, strings);
+      const recordCount = reader.varint();
+
+      if (recordCount > 0) {
+        let objects = { ...this.objects };
+        let added = false;
+        for (let n = 0; n < recordCount; n++) {
+          const name = strings[reader.varint()];
+          const kind = reader.byte();
+          const type = strings[reader.varint()];
+          const highlights = {};
+          for (let h = reader.varint(); h > 0; h--) {
+            const key = strings[reader.varint()];
+            highlights[key] = strings[reader.varint()];
+          }
+          const data = kind === RECORD_FULL ? reader.value() : applyEdits(objects[name].data, reader);
+          if (!(name in objects)) added = true;
+          objects[name] = { data, highlights, type };
+        }
+        this.objects = added ? sortedByName(objects) : objects;
+      }
+
+      frames[i] = dropped > 0 ? { dropped, message, objects: this.objects } : { message, objects: this.objects };
+    }
+    return frames;
+  }
+}
+
+export function decodeHistory(bytes) {
+  return new HistoryDecoder().decodeChunk(bytes);
+}
@@ -0,0 +1,75 @@
+// ########## Test: frame groups and exceptions ##########
+// Throws out of grouped scopes, caught both by the algorithm and by the runner, and checks that
+// every group still logs its one frame with its changes, and that message arguments which die
+// before the group does (a local string's c_str(), a string_view) are logged as they were.
+// Exits non-zero on a mismatch.
+
+#include "v-cpp.hpp"
+#include "include/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+void run_my_algorithm(VCtx &v)
+{
+    auto st = v.new_stack<int>("st");
+    {
+        VizFrameGroup group("Pushed {} values");
+        string count = "three", label = "a label long enough to be on the heap";
+        st.push(1), st.push(2), st.push(3);
+        group.message("Pushed {} values with {}", string_view(count), label.c_str());
+    } // `count` and `label` are gone by the time the group logs
+
+    try
+    {
+        VizFrameGroup group("Caught after {}", 2);
+        st.pop(), st.pop();
+        throw runtime_error("caught inside");
+    }
+    catch (const runtime_error &)
+    {
+        viz.log_frame("Recovered with {} left", st.data.size());
+    }
+
+    VizFrameGroup outer("Outer group");
+    VizFrameGroup inner("Inner group");
+    st.push(4);
+    throw runtime_error("thrown out of the algorithm");
+}
+
+int main()
+{
+    json history = json::parse(visualizeMyLogicWithBudget("", 0));
+    vector<string> messages;
+    for (const auto &frame : history)
+        messages.push_back(frame["message"].get<string>());
+    const vector<string> expected = {
+        "Successfully parsed input.",
+        "Created empty stack 'st'.",
+        "Pushed three values with a label long enough to be on the heap",
+        "Caught after 2",
+        "Recovered with 1 left",
+        "Outer group",
+        "Error: thrown out of the algorithm",
+    };
+    int failed = 0;
+    if (messages != expected)
+    {
+        fprintf(stderr, "Logged the frames\n");
+        for (const auto &message : messages)
+            fprintf(stderr, "  %s\n", message.c_str());
+        failed++;
+    }
+    else
+    {
+        // Each group's frame holds what its scope did to the stack
+        const vector<json> stacks = {{1, 2, 3}, {1}, {1}, {1, 4}, {1, 4}};
+        for (size_t i = 0; i < stacks.size(); ++i)
+        {
+            const json &data = history[i + 2]["objects"]["st"]["data"];
+            if (data != stacks[i] && ++failed)
+                fprintf(stderr, "'%s' shows the stack as %s, not %s\n", expected[i + 2].c_str(), data.dump().c_str(), stacks[i].dump().c_str());
+        }
+    }
+    printf("%zu frames checked, %d mismatches\n", messages.size(), failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+// ########## Test: unordered containers export in their iteration order ##########
+// Runs a few hundred inserts, erases and writes on every unordered wrapper, past the point where
+// a full version is forced (keyframe_interval ops), and after each step checks that the exported
+// frame holds exactly what serializing the live container gives. Exits non-zero on a mismatch.
+
+#include "v-cpp.hpp"
+#include "include/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+const int steps = 700;
+map<string, string> expected; // "check <i>" message -> the objects' data, as JSON text
+
+// The JSON the exporter writes for the live container, straight from its full serialization
+template <typename Wrapper>
+string exported(const Wrapper &w)
+{
+    string bytes = VizEngine::encode_value(w.data), text;
+    const char *p = bytes.data();
+    VizValueReader::to_json(p, text);
+    return text;
+}
+} // namespace
+
+void run_my_algorithm(VCtx &v)
+{
+    auto us = v.new_unordered_set<int>("us");
+    auto ums = v.new_unordered_multiset<int>("ums");
+    auto um = v.new_unordered_map<int, int>("um");
+    auto umm = v.new_unordered_multimap<int, int>("umm");
+    mt19937 rng(7);
+    for (int i = 0; i < steps; ++i)
+    {
+        int key = static_cast<int>(rng() % 400);
+        if (i % 5 == 4)
+            us.erase(key), ums.erase(key);
+        else
+            us.insert(key), ums.insert(key);
+        um[key] = i;
+        umm.insert({key, i});
+
+        string message = "check " + to_string(i);
+        expected[message] = json{{"um", json::parse(exported(um))}, {"umm", json::parse(exported(umm))},
+                                 {"ums", json::parse(exported(ums))}, {"us", json::parse(exported(us))}}
+                                .dump();
+        viz.log_frame(message);
+    }
+}
+
+int main()
+{
+    json history = json::parse(visualizeMyLogicWithBudget("", 0));
+    size_t checked = 0, failed = 0;
+    for (const auto &frame : history)
+    {
+        auto it = expected.find(frame["message"].get<string>());
+        if (it == expected.end())
+            continue;
+        json objects;
+        for (const char *name : {"um", "umm", "ums", "us"})
+            objects[name] = frame["objects"][name]["data"];
+        checked++;
+        if (objects.dump() != it->second && failed++ < 3)
+            fprintf(stderr, "%s: exported\n  %s\nbut the container holds\n  %s\n", it->first.c_str(), objects.dump().c_str(), it->second.c_str());
+    }
+    if (checked != expected.size())
+    {
+        fprintf(stderr, "Only %zu of the %zu checked frames were exported.\n", checked, expected.size());
+        return 1;
+    }
+    printf("%zu frames checked, %zu differ from the live containers\n", checked, failed);
+    return failed == 0 ? 0 : 1;
+}